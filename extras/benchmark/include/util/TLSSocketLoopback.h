@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+#ifndef TLS_SOCKET_LOOPBACK_H_
+#define TLS_SOCKET_LOOPBACK_H_
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <Client.h>
+#include <tls/bearssl/bearssl.h>
+
+/**************************************************************************************
+   CLASS DECLARATION
+ **************************************************************************************/
+
+/* Host Client connecting a BearSSLClient through a socketpair to a BearSSL server
+ * running in a thread of the same process. The server either consumes the data it
+ * receives, acknowledging each block of the expected size with a byte, or sends the
+ * data the client asked for once the handshake is over.
+ */
+class TLSSocketLoopback : public Client
+{
+public:
+
+  enum class Mode
+  {
+    Sink,
+    Source
+  };
+
+  TLSSocketLoopback();
+  virtual ~TLSSocketLoopback();
+
+  /* BearSSLClient profile: the library client profile offering only the cipher suite
+   * selected with setCipherSuite, validating the server with its public key.
+   */
+  static void clientProfile(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num);
+  static void setCipherSuite(uint16_t const suite);
+  static unsigned long getTime();
+
+  /* Used by the next connections */
+  inline void setMode(Mode const mode, size_t const block_size) { _mode = mode; _block_size = block_size; }
+
+  /* Application data records and bytes on the wire received by the server */
+  inline unsigned long getRecordCount() const { return _record_count; }
+  inline unsigned long getWireBytes() const { return _wire_bytes; }
+  inline uint16_t getCipherSuite() const { return _suite; }
+
+  virtual int connect(IPAddress ip, uint16_t port) override;
+  virtual int connect(const char * host, uint16_t port) override;
+  virtual size_t write(uint8_t b) override;
+  virtual size_t write(const uint8_t * buf, size_t size) override;
+  virtual int available() override;
+  virtual int read() override;
+  virtual int read(uint8_t * buf, size_t size) override;
+  virtual int peek() override;
+  virtual void flush() override;
+  virtual void stop() override;
+  virtual uint8_t connected() override;
+  virtual operator bool() override;
+
+private:
+
+  br_hmac_drbg_context _rng;
+  br_ec_private_key _sk;
+  unsigned char _sk_buf[BR_EC_KBUF_PRIV_MAX_SIZE];
+  br_ec_public_key _pk;
+  unsigned char _pk_buf[BR_EC_KBUF_PUB_MAX_SIZE];
+  std::vector<unsigned char> _chain_data;
+  br_x509_certificate _chain;
+
+  int _fd;
+  int _server_fd;
+  bool _peer_closed;
+  Mode _mode;
+  size_t _block_size;
+  std::thread _server;
+  std::atomic<unsigned long> _record_count;
+  std::atomic<unsigned long> _wire_bytes;
+  std::atomic<uint16_t> _suite;
+
+  /* Record header parser of the data received by the server */
+  unsigned char _header[5];
+  size_t _header_len;
+  size_t _record_left;
+
+  void serve(int const fd);
+  void countRecords(unsigned char const * buf, size_t len);
+  static int serverRead(void * ctx, unsigned char * buf, size_t len);
+  static int serverWrite(void * ctx, unsigned char const * buf, size_t len);
+};
+
+#endif /* TLS_SOCKET_LOOPBACK_H_ */
@@ -0,0 +1,157 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <AIoTC_Config.h>
+#include <Arduino.h>
+#include <TimedAttempt.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned int const  DEVICES              = 10000;
+static unsigned long const SIMULATION_STEP_ms   = 100UL;
+static unsigned long const SIMULATION_LENGTH_ms = 30UL * 60UL * 1000UL;
+/* The broker is down for a minute, then accepts a limited number of connections per second */
+static unsigned long const OUTAGE_ms            = 60UL * 1000UL;
+static unsigned int const  BROKER_ACCEPT_PER_s  = 250;
+static unsigned long const PLOT_BIN_ms          = 10UL * 1000UL;
+static unsigned long const PLOT_LENGTH_ms       = 5UL * 60UL * 1000UL;
+static unsigned int const  PLOT_WIDTH           = 60;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+struct Policy
+{
+  char const * name;
+  TimedAttempt::BackoffPolicy policy;
+};
+
+struct Result
+{
+  unsigned long attempts;
+  unsigned int peak_per_s;
+  unsigned long recovered_99_ms;
+  unsigned long recovered_ms;
+  std::vector<unsigned int> arrivals;
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static Result simulate(TimedAttempt::BackoffPolicy const policy)
+{
+  Result result = {0, 0, 0, 0, std::vector<unsigned int>(SIMULATION_LENGTH_ms / PLOT_BIN_ms, 0)};
+  std::vector<TimedAttempt> attempts(DEVICES, TimedAttempt(0, 0));
+  std::vector<bool> connected(DEVICES, false);
+  std::vector<unsigned int> per_second(SIMULATION_LENGTH_ms / 1000UL, 0);
+  unsigned int accepted_this_second = 0;
+  unsigned int disconnected = DEVICES;
+
+  /* The whole fleet loses the connection at the same time, as in ArduinoIoTCloudTCP::handle_Disconnect */
+  set_millis(0);
+  for (unsigned int d = 0; d < DEVICES; d++) {
+    attempts[d].setBackoffPolicy(policy, 0x9E3779B9UL * (d + 1));
+    attempts[d].begin(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+    attempts[d].retry();
+  }
+
+  for (unsigned long now_ms = SIMULATION_STEP_ms; now_ms < SIMULATION_LENGTH_ms && disconnected; now_ms += SIMULATION_STEP_ms)
+  {
+    set_millis(now_ms);
+    if ((now_ms % 1000UL) == 0) {
+      accepted_this_second = 0;
+    }
+
+    for (unsigned int d = 0; d < DEVICES; d++)
+    {
+      if (connected[d] || !attempts[d].isExpired()) {
+        continue;
+      }
+
+      result.attempts++;
+      per_second[now_ms / 1000UL]++;
+      result.arrivals[now_ms / PLOT_BIN_ms]++;
+
+      if (now_ms >= OUTAGE_ms && accepted_this_second < BROKER_ACCEPT_PER_s) {
+        accepted_this_second++;
+        connected[d] = true;
+        disconnected--;
+      } else {
+        attempts[d].retry();
+      }
+    }
+
+    if (!result.recovered_99_ms && disconnected <= DEVICES / 100) {
+      result.recovered_99_ms = now_ms;
+    }
+    if (!disconnected) {
+      result.recovered_ms = now_ms;
+    }
+  }
+
+  for (unsigned int const n : per_second) {
+    result.peak_per_s = n > result.peak_per_s ? n : result.peak_per_s;
+  }
+  return result;
+}
+
+static void plot(char const * name, Result const & result, unsigned int const scale)
+{
+  printf("\n%s, connection attempts every %lu s ('#' = %u attempts)\n", name, PLOT_BIN_ms / 1000UL, scale);
+  for (unsigned long bin = 0; bin < PLOT_LENGTH_ms / PLOT_BIN_ms; bin++)
+  {
+    unsigned int const n = result.arrivals[bin];
+    unsigned int const width = (n + scale - 1) / scale;
+    printf("%4lu s %6u |%s\n", bin * PLOT_BIN_ms / 1000UL, n, std::string(width > PLOT_WIDTH ? PLOT_WIDTH : width, '#').c_str());
+  }
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  Policy const policies[] = {
+    {"exponential", TimedAttempt::exponentialBackoff},
+    {"full-jitter", TimedAttempt::fullJitterBackoff},
+    {"decorrelated", TimedAttempt::decorrelatedJitterBackoff},
+  };
+  size_t const count = sizeof(policies) / sizeof(policies[0]);
+  Result results[count];
+
+  printf("%u devices, broker down for %lu s then accepting %u connections/s\n\n", DEVICES, OUTAGE_ms / 1000UL, BROKER_ACCEPT_PER_s);
+  printf("%-14s %10s %12s %16s %14s\n", "policy", "attempts", "peak/s", "99% recovered", "all recovered");
+
+  unsigned int scale = 1;
+  for (size_t p = 0; p < count; p++)
+  {
+    results[p] = simulate(policies[p].policy);
+    printf("%-14s %10lu %12u %14.1f s %12.1f s\n", policies[p].name, results[p].attempts, results[p].peak_per_s,
+           (results[p].recovered_99_ms ? results[p].recovered_99_ms : SIMULATION_LENGTH_ms) / 1000.0,
+           (results[p].recovered_ms ? results[p].recovered_ms : SIMULATION_LENGTH_ms) / 1000.0);
+
+    for (unsigned int const n : results[p].arrivals) {
+      scale = (n + PLOT_WIDTH - 1) / PLOT_WIDTH > scale ? (n + PLOT_WIDTH - 1) / PLOT_WIDTH : scale;
+    }
+  }
+
+  for (size_t p = 0; p < count; p++) {
+    plot(policies[p].name, results[p], scale);
+  }
+
+  return 0;
+}
@@ -0,0 +1,197 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+#include <tls/profile/aiotc_profile.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+/* The application data of a full TLS record */
+static size_t const       RECORD_SIZE = 16384;
+static unsigned int const RECORDS     = 64;
+static unsigned int const RUNS        = 15;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+struct Backend
+{
+  char const * name;
+  bool available;
+  bool is_default;
+  const br_block_ctr_class * aes_ctr;
+  br_ghash ghash;
+  br_chacha20_run chacha20;
+  br_poly1305_run poly1305;
+};
+
+/* Processes a record with the implementations of the backend */
+typedef void (*Record)(Backend const & backend, std::vector<unsigned char> & data);
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+/* CPU cycles on x86 hosts, nanoseconds on the others */
+static inline unsigned long long ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/* Cost per byte of a record, the median is not skewed by the other processes running on the host */
+static double measure(Record const record, Backend const & backend, std::vector<unsigned char> & data)
+{
+  std::vector<double> samples;
+
+  /* Warm up the caches */
+  record(backend, data);
+
+  for (unsigned int r = 0; r < RUNS; r++)
+  {
+    unsigned long long const start = ticks();
+    for (unsigned int i = 0; i < RECORDS; i++)
+      record(backend, data);
+    samples.push_back(double(ticks() - start) / (double(RECORDS) * data.size()));
+  }
+
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+static unsigned char const KEY[32] = {0x42};
+static unsigned char const IV[12] = {0x24};
+static unsigned char const AAD[13] = {0x17, 0x03, 0x03};
+
+static void aesCtrRecord(Backend const & backend, std::vector<unsigned char> & data)
+{
+  br_aes_gen_ctr_keys ctx;
+  backend.aes_ctr->init(&ctx.vtable, KEY, 16);
+  backend.aes_ctr->run(&ctx.vtable, IV, 1, data.data(), data.size());
+}
+
+static void ghashRecord(Backend const & backend, std::vector<unsigned char> & data)
+{
+  unsigned char y[16] = {0};
+  backend.ghash(y, KEY, data.data(), data.size());
+  data[0] ^= y[0];
+}
+
+static void chacha20Record(Backend const & backend, std::vector<unsigned char> & data)
+{
+  backend.chacha20(KEY, IV, 1, data.data(), data.size());
+}
+
+static void gcmRecord(Backend const & backend, std::vector<unsigned char> & data)
+{
+  br_aes_gen_ctr_keys aes;
+  br_gcm_context gcm;
+  unsigned char tag[16];
+
+  backend.aes_ctr->init(&aes.vtable, KEY, 16);
+  br_gcm_init(&gcm, &aes.vtable, backend.ghash);
+  br_gcm_reset(&gcm, IV, sizeof(IV));
+  br_gcm_aad_inject(&gcm, AAD, sizeof(AAD));
+  br_gcm_flip(&gcm);
+  br_gcm_run(&gcm, 1, data.data(), data.size());
+  br_gcm_get_tag(&gcm, tag);
+}
+
+static void chapolRecord(Backend const & backend, std::vector<unsigned char> & data)
+{
+  unsigned char tag[16];
+  backend.poly1305(KEY, IV, data.data(), data.size(), AAD, sizeof(AAD), tag, backend.chacha20, 1);
+}
+
+static void report(char const * section, Record const record, std::vector<Backend> const & backends, std::vector<unsigned char> & data)
+{
+  printf("\n%s\n", section);
+  for (Backend const & backend : backends)
+  {
+    if (!backend.available) {
+      printf("  %-28s %14s\n", backend.name, "not available");
+      continue;
+    }
+    printf("  %-28s %14.2f %s\n", backend.name, measure(record, backend, data), backend.is_default ? "(profile default)" : "");
+  }
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  aiotc_profile_config defaults;
+  aiotc_client_profile_defaults(&defaults);
+  std::vector<unsigned char> data(RECORD_SIZE, 0x55);
+
+  /* The getters return NULL when the host or the build lacks the instructions */
+  br_block_ctr_class const * aes_x86ni = br_aes_x86ni_ctr_get_vtable();
+  br_ghash const ghash_pclmul = br_ghash_pclmul_get();
+  br_chacha20_run const chacha20_sse2 = br_chacha20_sse2_get();
+  br_poly1305_run const poly1305_ctmulq = br_poly1305_ctmulq_get();
+
+#if defined(__x86_64__) || defined(__i386__)
+  char const * unit = "cycles per byte";
+#else
+  char const * unit = "nanoseconds per byte";
+#endif
+  printf("Symmetric crypto implementations of BearSSL on %zu bytes records, median %s\n", RECORD_SIZE, unit);
+
+  report("AES-128 CTR", aesCtrRecord, {
+    {"aes_big",   true,                 false,                                        &br_aes_big_ctr_vtable,   nullptr, nullptr, nullptr},
+    {"aes_small", true,                 false,                                        &br_aes_small_ctr_vtable, nullptr, nullptr, nullptr},
+    {"aes_ct",    true,                 defaults.aes_ctr == &br_aes_ct_ctr_vtable,   &br_aes_ct_ctr_vtable,    nullptr, nullptr, nullptr},
+    {"aes_ct64",  true,                 defaults.aes_ctr == &br_aes_ct64_ctr_vtable, &br_aes_ct64_ctr_vtable,  nullptr, nullptr, nullptr},
+    {"aes_x86ni", aes_x86ni != nullptr, defaults.aes_ctr == aes_x86ni,               aes_x86ni,                nullptr, nullptr, nullptr},
+  }, data);
+
+  report("GHASH", ghashRecord, {
+    {"ghash_ctmul",   true,                    defaults.ghash == &br_ghash_ctmul,   nullptr, &br_ghash_ctmul,   nullptr, nullptr},
+    {"ghash_ctmul32", true,                    defaults.ghash == &br_ghash_ctmul32, nullptr, &br_ghash_ctmul32, nullptr, nullptr},
+    {"ghash_ctmul64", true,                    defaults.ghash == &br_ghash_ctmul64, nullptr, &br_ghash_ctmul64, nullptr, nullptr},
+    {"ghash_pclmul",  ghash_pclmul != nullptr, defaults.ghash == ghash_pclmul,      nullptr, ghash_pclmul,      nullptr, nullptr},
+  }, data);
+
+  report("ChaCha20", chacha20Record, {
+    {"chacha20_ct",   true,                     defaults.chacha20 == &br_chacha20_ct_run, nullptr, nullptr, &br_chacha20_ct_run, nullptr},
+    {"chacha20_sse2", chacha20_sse2 != nullptr, defaults.chacha20 == chacha20_sse2,       nullptr, nullptr, chacha20_sse2,       nullptr},
+  }, data);
+
+  report("ChaCha20-Poly1305 AEAD, with the default ChaCha20", chapolRecord, {
+    {"poly1305_ctmul",   true,                       defaults.poly1305 == &br_poly1305_ctmul_run,   nullptr, nullptr, defaults.chacha20, &br_poly1305_ctmul_run},
+    {"poly1305_ctmul32", true,                       defaults.poly1305 == &br_poly1305_ctmul32_run, nullptr, nullptr, defaults.chacha20, &br_poly1305_ctmul32_run},
+    {"poly1305_i15",     true,                       false,                                         nullptr, nullptr, defaults.chacha20, &br_poly1305_i15_run},
+    {"poly1305_ctmulq",  poly1305_ctmulq != nullptr, defaults.poly1305 == poly1305_ctmulq,          nullptr, nullptr, defaults.chacha20, poly1305_ctmulq},
+  }, data);
+
+  report("AES-128/GCM AEAD", gcmRecord, {
+    {"Cortex-M (aes_ct, ctmul32)", true,                                          false, &br_aes_ct_ctr_vtable,   &br_ghash_ctmul32, nullptr, nullptr},
+    {"64-bit (aes_ct64, ctmul64)", true,                                          false, &br_aes_ct64_ctr_vtable, &br_ghash_ctmul64, nullptr, nullptr},
+    {"AES-NI (aes_x86ni, pclmul)", aes_x86ni != nullptr && ghash_pclmul != nullptr, false, aes_x86ni,               ghash_pclmul,      nullptr, nullptr},
+    {"profile",                    true,                                          true,  defaults.aes_ctr,        defaults.ghash,    nullptr, nullptr},
+  }, data);
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <ctime>
+#include <cstdio>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned int const ITERATIONS = 100000;
+static unsigned int const ROUNDS     = 7;      /* The fastest round, in CPU time, is reported to filter out scheduling noise */
+static size_t const       MQTT_TRANSMIT_BUFFER_SIZE = 256;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+/* A thing mixing primitive and multi value properties, all published on every call to encode */
+struct Thing
+{
+  PropertyContainer container;
+  CloudFloat temperature;
+  CloudFloat humidity;
+  CloudFloat pressure;
+  CloudInt counter;
+  CloudBool alarm;
+  CloudLocation location;
+  CloudColoredLight light;
+
+  Thing()
+  : temperature{21.5f}
+  , humidity{45.0f}
+  , pressure{1013.25f}
+  , counter{0}
+  , alarm{false}
+  , location{45.0f, 7.0f}
+  , light{true, 120.0f, 80.0f, 100.0f}
+  {
+    addPropertyToContainer(container, temperature, "temperature", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, humidity, "humidity", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, pressure, "pressure", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, counter, "counter", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, alarm, "alarm", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, location, "location", Permission::Read).publishEvery(0);
+    addPropertyToContainer(container, light, "light", Permission::Read).publishEvery(0);
+  }
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static void run(char const * name, bool const lightPayload)
+{
+  Thing thing;
+  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
+  unsigned int property_index = 0;
+  unsigned long total_bytes = 0;
+  double ns = 0.0;
+
+  for (unsigned int r = 0; r < ROUNDS; r++)
+  {
+    total_bytes = 0;
+    std::clock_t const start = std::clock();
+    for (unsigned int i = 0; i < ITERATIONS; i++)
+    {
+      int bytes_encoded = 0;
+      CBOREncoder::encode(thing.container, data, sizeof(data), bytes_encoded, property_index, lightPayload);
+      total_bytes += bytes_encoded;
+    }
+    std::clock_t const stop = std::clock();
+    double const round_ns = 1e9 * static_cast<double>(stop - start) / CLOCKS_PER_SEC;
+    if ((r == 0) || (round_ns < ns))
+      ns = round_ns;
+  }
+
+  printf("%-14s %10.1f ns/message %8.1f bytes/message %8.2f ns/byte\n", name, ns / ITERATIONS, static_cast<double>(total_bytes) / ITERATIONS, ns / total_bytes);
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  set_millis(0);
+  run("string names", false);
+  run("light payload", true);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <util/TLSLoopback.h>
+#include <tls/BearSSLClient.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned int const HANDSHAKES = 200;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+typedef std::chrono::duration<double, std::micro> Microseconds;
+
+struct Curve
+{
+  char const * name;
+  void (*profile)(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num);
+};
+
+struct Result
+{
+  Microseconds wall;
+  Microseconds client;
+  Microseconds precompute;
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+/* The median is not skewed by the other processes running on the host */
+static Microseconds median(std::vector<Microseconds> samples)
+{
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+/* The loopback server prefers x25519, only offer secp256r1 to measure it */
+static void p256Profile(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num)
+{
+  TLSLoopback::clientProfile(cc, xc, trust_anchors, trust_anchors_num);
+  br_ssl_engine_set_ec(&cc->eng, &br_ec_p256_m15);
+}
+
+static Result measure(Curve const & curve, bool const precompute)
+{
+  std::vector<Microseconds> wall, client, idle;
+  TLSLoopback server;
+  BearSSLClient tls;
+  std::vector<unsigned char> ibuf(BEAR_SSL_CLIENT_IBUF_SIZE), obuf(BEAR_SSL_CLIENT_OBUF_SIZE);
+
+  tls.setClient(server);
+  tls.setProfile(curve.profile);
+  tls.onGetTime(TLSLoopback::getTime);
+  tls.setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  /* Full handshakes only, a resumed one has no key exchange */
+  tls.setSessionResumption(false);
+
+  /* The key share is precomputed on the curve chosen by the server in the last handshake */
+  tls.connect("loopback", 443);
+  tls.stop();
+  BearSSLClient::clearKeyShare();
+
+  for (unsigned int h = 0; h < HANDSHAKES; h++)
+  {
+    if (precompute) {
+      /* Idle time, before the connection is lost */
+      auto const start = std::chrono::steady_clock::now();
+      BearSSLClient::precomputeKeyShare();
+      idle.push_back(std::chrono::steady_clock::now() - start);
+    } else {
+      idle.push_back(Microseconds(0));
+    }
+
+    auto const server_start = server.getServerTime();
+    auto const start = std::chrono::steady_clock::now();
+    if (tls.connect("loopback", 443) != 1) {
+      printf("handshake failed: %d\n", tls.errorCode());
+      break;
+    }
+    Microseconds const elapsed = std::chrono::steady_clock::now() - start;
+    wall.push_back(elapsed);
+    client.push_back(elapsed - (server.getServerTime() - server_start));
+    tls.stop();
+  }
+
+  return Result{median(wall), median(client), median(idle)};
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  Curve const curves[] = {
+    {"secp256r1", p256Profile},
+    {"x25519", TLSLoopback::clientProfile},
+  };
+
+  printf("%u full handshakes of BearSSLClient with a loopback BearSSL server, median time per handshake\n\n", HANDSHAKES);
+  printf("%-10s %-14s %12s %12s %14s\n", "curve", "key share", "wall", "client", "idle");
+
+  for (Curve const & curve : curves)
+  {
+    Result const computed = measure(curve, false);
+    Result const precomputed = measure(curve, true);
+
+    printf("%-10s %-14s %9.1f us %9.1f us %11.1f us\n", curve.name, "in handshake", computed.wall.count(), computed.client.count(), computed.precompute.count());
+    printf("%-10s %-14s %9.1f us %9.1f us %11.1f us\n", curve.name, "precomputed", precomputed.wall.count(), precomputed.client.count(), precomputed.precompute.count());
+    printf("%-10s %-14s %9.1f %% %9.1f %%\n\n", curve.name, "saved",
+           100.0 * (computed.wall - precomputed.wall) / computed.wall,
+           100.0 * (computed.client - precomputed.client) / computed.client);
+  }
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned long const SIMULATION_STEP_ms   = 60UL * 1000UL;   /* Sensors are sampled every minute */
+static unsigned long const UPLINK_INTERVAL_ms   = 5UL * 60UL * 1000UL;
+static unsigned long const SIMULATION_LENGTH_ms = 24UL * 60UL * 60UL * 1000UL;
+static size_t const        CBOR_LORA_MSG_MAX_SIZE = 255;
+
+/* LoRaWAN EU868 application payload limits for DR0, DR3 and DR5 */
+static size_t const FRAME_SIZES[] = { 51, 115, 222 };
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+/* The same set of properties a typical LoRa weather station sketch would register */
+struct Thing
+{
+  PropertyContainer container;
+  CloudFloat temperature;
+  CloudFloat humidity;
+  CloudFloat pressure;
+  CloudInt battery;
+  CloudInt counter;
+  CloudBool alarm;
+  CloudString status;
+  CloudLocation location;
+
+  Thing()
+  : temperature{21.0f}
+  , humidity{45.0f}
+  , pressure{1013.0f}
+  , battery{100}
+  , counter{0}
+  , alarm{false}
+  , location{45.0f, 7.0f}
+  {
+    addPropertyToContainer(container, temperature, "temperature", Permission::Read, 1).publishOnChange(0.1f);
+    addPropertyToContainer(container, status, "status", Permission::Read, 2);
+    addPropertyToContainer(container, humidity, "humidity", Permission::Read, 3).publishOnChange(0.5f);
+    addPropertyToContainer(container, pressure, "pressure", Permission::Read, 4).publishOnChange(0.2f);
+    addPropertyToContainer(container, battery, "battery", Permission::Read, 5);
+    addPropertyToContainer(container, counter, "counter", Permission::Read, 6);
+    addPropertyToContainer(container, alarm, "alarm", Permission::Read, 7).priority(Priority::High);
+    addPropertyToContainer(container, location, "location", Permission::Read, 8);
+  }
+};
+
+struct Result
+{
+  unsigned int uplinks;
+  unsigned int failed;
+  unsigned long bytes;
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static float randomStep(float const amplitude)
+{
+  return amplitude * ((static_cast<float>(rand()) / RAND_MAX) - 0.5f);
+}
+
+/* Apply the same pseudo random sequence of changes to every simulated thing */
+static void simulateChanges(Thing & thing, unsigned long const now_ms, unsigned int const seed)
+{
+  srand(seed);
+  thing.temperature = thing.temperature + randomStep(0.6f);
+  thing.humidity = thing.humidity + randomStep(2.0f);
+  thing.pressure = thing.pressure + randomStep(0.8f);
+  thing.counter = thing.counter + 1;
+
+  if ((now_ms % (30UL * 60UL * 1000UL)) == 0)
+    thing.battery = thing.battery - 1;
+
+  if ((rand() % 97) == 0)
+    thing.alarm = !thing.alarm;
+
+  if ((now_ms % (2UL * 60UL * 60UL * 1000UL)) == 0) {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "maintenance check %lu: all sensors nominal", now_ms / 1000UL);
+    thing.status = String(msg);
+  }
+
+  if ((now_ms % (6UL * 60UL * 60UL * 1000UL)) == 0) {
+    CloudLocation location(45.0f + randomStep(0.01f), 7.0f + randomStep(0.01f));
+    thing.location = location;
+  }
+}
+
+static void uplink(Thing & thing, size_t const frame_size, bool const packing, bool const compact, unsigned int & property_index, Result & result)
+{
+  uint8_t data[CBOR_LORA_MSG_MAX_SIZE];
+  int bytes_encoded = 0;
+  CborError error = CborNoError;
+
+  if (packing)
+    error = CBOREncoder::encodePacked(thing.container, data, frame_size, bytes_encoded, true, compact);
+  else
+    error = CBOREncoder::encode(thing.container, data, frame_size, bytes_encoded, property_index, true, compact);
+
+  if (error != CborNoError)
+    result.failed++;
+  else if (bytes_encoded > 0) {
+    result.uplinks++;
+    result.bytes += bytes_encoded;
+  }
+}
+
+static void print(char const * strategy, size_t const frame_size, Result const & result)
+{
+  double const mean = result.uplinks ? static_cast<double>(result.bytes) / result.uplinks : 0.0;
+  printf("%-12s %6zu %8u %8u %10lu %12.1f %10.1f%%\n",
+         strategy, frame_size, result.uplinks, result.failed, result.bytes, mean, 100.0 * mean / frame_size);
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  printf("Simulated day: %lu uplink slots, one every %lu s\n\n", SIMULATION_LENGTH_ms / UPLINK_INTERVAL_ms, UPLINK_INTERVAL_ms / 1000UL);
+  printf("%-12s %6s %8s %8s %10s %12s %11s\n", "strategy", "frame", "uplinks", "failed", "bytes", "bytes/uplink", "frame use");
+
+  for (size_t f = 0; f < sizeof(FRAME_SIZES) / sizeof(FRAME_SIZES[0]); f++)
+  {
+    Thing round_robin, packed, compact;
+    Result round_robin_result = {0, 0, 0}, packed_result = {0, 0, 0}, compact_result = {0, 0, 0};
+    unsigned int property_index = 0;
+    round_robin.status = "booting";
+    packed.status = "booting";
+    compact.status = "booting";
+
+    for (unsigned long now_ms = 0; now_ms < SIMULATION_LENGTH_ms; now_ms += SIMULATION_STEP_ms)
+    {
+      set_millis(now_ms);
+      unsigned int const seed = static_cast<unsigned int>(now_ms / SIMULATION_STEP_ms) + 1;
+      simulateChanges(round_robin, now_ms, seed);
+      simulateChanges(packed, now_ms, seed);
+      simulateChanges(compact, now_ms, seed);
+
+      if ((now_ms % UPLINK_INTERVAL_ms) == 0)
+      {
+        uplink(round_robin, FRAME_SIZES[f], false, false, property_index, round_robin_result);
+        uplink(packed, FRAME_SIZES[f], true, false, property_index, packed_result);
+        uplink(compact, FRAME_SIZES[f], true, true, property_index, compact_result);
+      }
+    }
+
+    print("round-robin", FRAME_SIZES[f], round_robin_result);
+    print("knapsack", FRAME_SIZES[f], packed_result);
+    print("compact", FRAME_SIZES[f], compact_result);
+  }
+
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+
+#include <util/FileOutboxStorage.h>
+#include <PersistentOutbox.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static char const          STORAGE_FILE[]        = "benchmark_PersistentOutbox.bin";
+static size_t const        SECTOR_SIZE           = 4096;
+static size_t const        SECTOR_COUNT          = 16;
+static size_t const        MESSAGE_SIZE          = 256;
+static size_t const        BANDWIDTH_LIMIT       = 2048;
+static size_t const        BURST_SIZE            = 4;
+static unsigned long const SIMULATION_STEP_ms    = 1000UL;
+static unsigned long const RECORD_INTERVAL_ms    = 10UL * 1000UL;
+static unsigned long const SIMULATION_LENGTH_ms  = 7UL * 24UL * 60UL * 60UL * 1000UL;
+static unsigned long const REBOOT_INTERVAL_ms    = 6UL * 60UL * 60UL * 1000UL;
+static size_t const        RECORD_SIZE           = 20;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+struct Result
+{
+  unsigned long recorded;
+  unsigned long torn;
+  unsigned long delivered;
+  unsigned long out_of_order;
+  unsigned long messages;
+  unsigned long bytes;
+  unsigned long reboots;
+  double push_s;
+  double encode_s;
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+/* A record carrying its sequence number, [uint32, text] as a property snapshot with a time stamp would */
+static void makeRecord(uint8_t * record, uint32_t const sequence)
+{
+  record[0] = 0x1A;
+  record[1] = static_cast<uint8_t>(sequence >> 24);
+  record[2] = static_cast<uint8_t>(sequence >> 16);
+  record[3] = static_cast<uint8_t>(sequence >> 8);
+  record[4] = static_cast<uint8_t>(sequence);
+  record[5] = 0x60 | (RECORD_SIZE - 6);
+  for (size_t i = 6; i < RECORD_SIZE; i++)
+    record[i] = 'a' + (i % 26);
+}
+
+static uint32_t recordSequence(uint8_t const * record)
+{
+  return (static_cast<uint32_t>(record[1]) << 24) | (static_cast<uint32_t>(record[2]) << 16) |
+         (static_cast<uint32_t>(record[3]) << 8)  |  static_cast<uint32_t>(record[4]);
+}
+
+/* The connection is down for 2 hours every 9 hours, and for 20 minutes every 50 minutes */
+static bool isOnline(unsigned long const now_ms)
+{
+  return ((now_ms % (9UL * 60UL * 60UL * 1000UL)) >= (2UL * 60UL * 60UL * 1000UL)) &&
+         ((now_ms % (50UL * 60UL * 1000UL)) >= (20UL * 60UL * 1000UL));
+}
+
+static void deliver(PersistentOutbox & outbox, uint32_t & next_expected, Result & result)
+{
+  for (size_t burst = 0; (burst < BURST_SIZE) && !outbox.isEmpty(); burst++)
+  {
+    uint8_t data[MESSAGE_SIZE];
+    int bytes_encoded = 0;
+
+    std::clock_t const start = std::clock();
+    size_t const count = outbox.encode(data, sizeof(data), bytes_encoded);
+    result.encode_s += static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    if (count == 0)
+      return;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      uint32_t const sequence = recordSequence(data + 1 + i * RECORD_SIZE);
+      if (sequence < next_expected)
+        result.out_of_order++;
+      next_expected = sequence + 1;
+    }
+
+    outbox.release(count);
+    result.delivered += count;
+    result.messages++;
+    result.bytes += bytes_encoded;
+  }
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  std::remove(STORAGE_FILE);
+
+  Result result = {0, 0, 0, 0, 0, 0, 0, 0.0, 0.0};
+  FileOutboxStorage * storage = new FileOutboxStorage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+  PersistentOutbox * outbox = new PersistentOutbox(MESSAGE_SIZE);
+  uint32_t sequence = 0;
+  uint32_t next_expected = 0;
+  unsigned long erase_count[SECTOR_COUNT] = {0};
+
+  set_millis(0);
+  outbox->begin(*storage);
+  outbox->setBandwidthLimit(BANDWIDTH_LIMIT);
+
+  for (unsigned long now_ms = SIMULATION_STEP_ms; now_ms < SIMULATION_LENGTH_ms; now_ms += SIMULATION_STEP_ms)
+  {
+    set_millis(now_ms);
+
+    if ((now_ms % REBOOT_INTERVAL_ms) == 0)
+    {
+      /* Every other reboot happens while a record is being written */
+      if ((result.reboots % 2) == 0)
+      {
+        uint8_t record[RECORD_SIZE];
+        makeRecord(record, sequence++);
+        storage->failAfter(static_cast<size_t>(rand()) % (RECORD_SIZE + 4));
+        if (!outbox->push(record, sizeof(record)))
+          result.torn++;
+        else
+          result.recorded++;
+      }
+
+      for (size_t s = 0; s < SECTOR_COUNT; s++)
+        erase_count[s] += storage->getEraseCount(s);
+      delete outbox;
+      delete storage;
+      storage = new FileOutboxStorage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+      outbox = new PersistentOutbox(MESSAGE_SIZE);
+      outbox->begin(*storage);
+      outbox->setBandwidthLimit(BANDWIDTH_LIMIT);
+      result.reboots++;
+    }
+
+    bool const online = isOnline(now_ms);
+    if (!online && ((now_ms % RECORD_INTERVAL_ms) == 0))
+    {
+      uint8_t record[RECORD_SIZE];
+      makeRecord(record, sequence++);
+      std::clock_t const start = std::clock();
+      if (outbox->push(record, sizeof(record)))
+        result.recorded++;
+      result.push_s += static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    }
+
+    if (online)
+      deliver(*outbox, next_expected, result);
+  }
+
+  unsigned long min_erase = 0, max_erase = 0;
+  for (size_t s = 0; s < SECTOR_COUNT; s++)
+  {
+    erase_count[s] += storage->getEraseCount(s);
+    if ((s == 0) || (erase_count[s] < min_erase)) min_erase = erase_count[s];
+    if ((s == 0) || (erase_count[s] > max_erase)) max_erase = erase_count[s];
+  }
+
+  printf("Simulated week: %lu reboots, storage %zu x %zu bytes, replay limited to %zu bytes/s\n\n",
+         result.reboots, SECTOR_COUNT, SECTOR_SIZE, BANDWIDTH_LIMIT);
+  printf("records recorded        %10lu\n", result.recorded);
+  printf("records torn by reset   %10lu\n", result.torn);
+  printf("records delivered       %10lu\n", result.delivered);
+  printf("records dropped (full)  %10lu\n", static_cast<unsigned long>(outbox->getDroppedCount()));
+  printf("records still queued    %10lu\n", static_cast<unsigned long>(outbox->count()));
+  printf("records out of order    %10lu\n", result.out_of_order);
+  printf("messages                %10lu\n", result.messages);
+  printf("bytes/message           %10.1f\n", result.messages ? static_cast<double>(result.bytes) / result.messages : 0.0);
+  printf("sector erases min/max   %6lu/%-6lu\n", min_erase, max_erase);
+  printf("push                    %10.2f us/record\n", result.recorded ? 1e6 * result.push_s / result.recorded : 0.0);
+  printf("encode                  %10.2f us/message\n", result.messages ? 1e6 * result.encode_s / result.messages : 0.0);
+
+  delete outbox;
+  delete storage;
+  std::remove(STORAGE_FILE);
+  return 0;
+}
@@ -0,0 +1,211 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <util/TLSSocketLoopback.h>
+#include <tls/BearSSLClient.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned int const HANDSHAKES      = 50;
+static size_t const       BULK_SIZE       = 4UL * 1024UL * 1024UL;
+static size_t const       BULK_CHUNK_SIZE = 1024;
+static unsigned int const PUBLISHES       = 100;
+static size_t const       PAYLOAD_SIZE    = 64;
+static unsigned int const BURST_SIZE      = 4;
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+struct Suite
+{
+  char const * name;
+  uint16_t id;
+};
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static void setup(BearSSLClient & tls, TLSSocketLoopback & loopback, std::vector<unsigned char> & ibuf, std::vector<unsigned char> & obuf)
+{
+  tls.setClient(loopback);
+  tls.setProfile(TLSSocketLoopback::clientProfile);
+  tls.onGetTime(TLSSocketLoopback::getTime);
+  tls.setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  /* Full handshakes only */
+  tls.setSessionResumption(false);
+}
+
+static bool waitAck(BearSSLClient & tls)
+{
+  uint8_t ack = 0;
+  return tls.read(&ack, 1) == 1;
+}
+
+static Milliseconds handshake(BearSSLClient & tls, TLSSocketLoopback & loopback)
+{
+  std::vector<Milliseconds> samples;
+
+  loopback.setMode(TLSSocketLoopback::Mode::Sink, 1);
+  for (unsigned int h = 0; h < HANDSHAKES; h++)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    if (tls.connect("loopback", 443) != 1)
+      return Milliseconds(0);
+    samples.push_back(std::chrono::steady_clock::now() - start);
+    tls.stop();
+  }
+
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+static double upload(BearSSLClient & tls, TLSSocketLoopback & loopback)
+{
+  std::vector<uint8_t> chunk(BULK_CHUNK_SIZE, 0xAA);
+
+  loopback.setMode(TLSSocketLoopback::Mode::Sink, BULK_SIZE);
+  if (tls.connect("loopback", 443) != 1)
+    return 0.0;
+
+  auto const start = std::chrono::steady_clock::now();
+  for (size_t sent = 0; sent < BULK_SIZE; sent += chunk.size()) {
+    if (tls.write(chunk.data(), chunk.size()) != chunk.size())
+      break;
+  }
+  bool const done = waitAck(tls);
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  tls.stop();
+
+  return done ? (BULK_SIZE / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
+}
+
+static double download(BearSSLClient & tls, TLSSocketLoopback & loopback)
+{
+  std::vector<uint8_t> chunk(BULK_CHUNK_SIZE);
+  uint32_t const size = BULK_SIZE;
+  size_t received = 0;
+
+  loopback.setMode(TLSSocketLoopback::Mode::Source, 0);
+  if (tls.connect("loopback", 443) != 1)
+    return 0.0;
+
+  auto const start = std::chrono::steady_clock::now();
+  tls.write(reinterpret_cast<uint8_t const *>(&size), sizeof(size));
+  while (received < BULK_SIZE) {
+    int const len = tls.read(chunk.data(), chunk.size());
+    if (len <= 0)
+      break;
+    received += len;
+  }
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  tls.stop();
+
+  return (received == BULK_SIZE) ? (BULK_SIZE / (1024.0 * 1024.0)) / elapsed.count() : 0.0;
+}
+
+/* Writes a PUBLISH the way ArduinoMqttClient does: fixed header, topic and payload separately */
+static size_t publish(BearSSLClient & tls, std::string const & topic)
+{
+  std::vector<uint8_t> const payload(PAYLOAD_SIZE, 0x55);
+  uint8_t const header[] = {0x30, static_cast<uint8_t>(2 + topic.length() + payload.size())};
+  uint8_t const topic_length[] = {0x00, static_cast<uint8_t>(topic.length())};
+
+  tls.write(header, sizeof(header));
+  tls.write(topic_length, sizeof(topic_length));
+  tls.write(reinterpret_cast<uint8_t const *>(topic.data()), topic.length());
+  tls.write(payload.data(), payload.size());
+  return sizeof(header) + sizeof(topic_length) + topic.length() + payload.size();
+}
+
+static void publishes(BearSSLClient & tls, TLSSocketLoopback & loopback, char const * name, unsigned int const burst, bool const cork)
+{
+  std::string const topic("/a/t/xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx/e/o");
+  size_t const packet_size = 4 + topic.length() + PAYLOAD_SIZE;
+
+  loopback.setMode(TLSSocketLoopback::Mode::Sink, packet_size * burst);
+  if (tls.connect("loopback", 443) != 1)
+    return;
+
+  unsigned long const records = loopback.getRecordCount();
+  unsigned long const bytes = loopback.getWireBytes();
+
+  for (unsigned int p = 0; p < PUBLISHES; p += burst)
+  {
+    if (cork)
+      tls.cork();
+    for (unsigned int b = 0; b < burst; b++)
+      publish(tls, topic);
+    if (cork)
+      tls.uncork();
+    waitAck(tls);
+  }
+
+  printf("%-26s %12.2f %14.1f %14.1f\n", name,
+         double(loopback.getRecordCount() - records) / PUBLISHES,
+         double(loopback.getWireBytes() - bytes) / PUBLISHES,
+         double(loopback.getWireBytes() - bytes) / PUBLISHES - packet_size);
+  tls.stop();
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  Suite const suites[] = {
+    {"ECDHE_ECDSA_AES_128_GCM_SHA256", BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256},
+    {"ECDHE_ECDSA_AES_256_GCM_SHA384", BR_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384},
+    {"ECDHE_ECDSA_CHACHA20_POLY1305", BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256},
+    {"ECDHE_ECDSA_AES_128_CCM", BR_TLS_ECDHE_ECDSA_WITH_AES_128_CCM},
+    {"ECDHE_ECDSA_AES_128_CBC_SHA256", BR_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256},
+  };
+
+  TLSSocketLoopback loopback;
+  BearSSLClient tls;
+  /* The buffers of a board with a crypto chip */
+  std::vector<unsigned char> ibuf(BEAR_SSL_CLIENT_IBUF_SIZE), obuf(BEAR_SSL_CLIENT_OBUF_SIZE);
+  setup(tls, loopback, ibuf, obuf);
+
+  printf("BearSSLClient with a BearSSL server thread over a socketpair, %zu bytes input and %zu bytes output buffers\n\n", ibuf.size(), obuf.size());
+  printf("%-32s %14s %14s %14s\n", "cipher suite", "handshake", "upload", "download");
+
+  for (Suite const & suite : suites)
+  {
+    TLSSocketLoopback::setCipherSuite(suite.id);
+    Milliseconds const hs = handshake(tls, loopback);
+    double const up = upload(tls, loopback);
+    if (loopback.getCipherSuite() != suite.id) {
+      printf("%-32s not negotiated\n", suite.name);
+      continue;
+    }
+    double const down = download(tls, loopback);
+    printf("%-32s %11.2f ms %9.2f MB/s %9.2f MB/s\n", suite.name, hs.count(), up, down);
+  }
+
+  TLSSocketLoopback::setCipherSuite(BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256);
+  printf("\n%u MQTT publishes of %zu bytes payload, per publish\n\n", PUBLISHES, PAYLOAD_SIZE);
+  printf("%-26s %12s %14s %14s\n", "writes", "TLS records", "wire bytes", "TLS overhead");
+  publishes(tls, loopback, "one record per write", 1, false);
+  publishes(tls, loopback, "corked publish", 1, true);
+  publishes(tls, loopback, "corked burst of 4", BURST_SIZE, true);
+
+  return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <util/TLSSocketLoopback.h>
+#include <tls/profile/aiotc_profile.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static int const READ_TIMEOUT_ms = 5000;
+
+/**************************************************************************************
+   GLOBAL VARIABLES
+ **************************************************************************************/
+
+static br_ec_public_key const * loopback_server_pk = nullptr;
+static br_x509_knownkey_context loopback_known_key;
+static uint16_t loopback_suite = BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256;
+
+/**************************************************************************************
+   CTOR/DTOR
+ **************************************************************************************/
+
+TLSSocketLoopback::TLSSocketLoopback()
+: _chain_data(512, 0x30)
+, _fd{-1}
+, _server_fd{-1}
+, _peer_closed{false}
+, _mode{Mode::Sink}
+, _block_size{1}
+, _record_count{0}
+, _wire_bytes{0}
+, _suite{0}
+, _header_len{0}
+, _record_left{0}
+{
+  /* Always the same server key, the client only knows its public part */
+  br_hmac_drbg_init(&_rng, &br_sha256_vtable, "TLSSocketLoopback", 17);
+  br_ec_keygen(&_rng.vtable, br_ec_get_default(), &_sk, _sk_buf, BR_EC_secp256r1);
+  br_ec_compute_pub(br_ec_get_default(), &_pk, _pk_buf, &_sk);
+
+  /* The client validates the server by its key, the chain content is not looked at */
+  _chain.data = _chain_data.data();
+  _chain.data_len = _chain_data.size();
+}
+
+TLSSocketLoopback::~TLSSocketLoopback()
+{
+  stop();
+}
+
+/**************************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void TLSSocketLoopback::clientProfile(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num)
+{
+  aiotc_client_profile_init(cc, xc, trust_anchors, trust_anchors_num);
+
+  /* All the symmetric implementations, only the selected suite is offered */
+  br_ssl_engine_set_hash(&cc->eng, br_sha384_ID, &br_sha384_vtable);
+  br_ssl_engine_set_prf_sha384(&cc->eng, &br_tls12_sha384_prf);
+  br_ssl_engine_set_default_aes_cbc(&cc->eng);
+  br_ssl_engine_set_default_aes_ccm(&cc->eng);
+  br_ssl_engine_set_default_chapol(&cc->eng);
+  br_ssl_engine_set_suites(&cc->eng, &loopback_suite, 1);
+
+  br_x509_knownkey_init_ec(&loopback_known_key, loopback_server_pk, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN);
+  br_ssl_engine_set_x509(&cc->eng, &loopback_known_key.vtable);
+}
+
+void TLSSocketLoopback::setCipherSuite(uint16_t const suite)
+{
+  loopback_suite = suite;
+}
+
+unsigned long TLSSocketLoopback::getTime()
+{
+  return 1700000000UL;
+}
+
+int TLSSocketLoopback::connect(IPAddress, uint16_t)
+{
+  return connect("loopback", 0);
+}
+
+int TLSSocketLoopback::connect(const char *, uint16_t)
+{
+  int fds[2];
+
+  stop();
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    return 0;
+
+  loopback_server_pk = &_pk;
+  _fd = fds[0];
+  _peer_closed = false;
+  _record_count = 0;
+  _wire_bytes = 0;
+  _suite = 0;
+  _header_len = 0;
+  _record_left = 0;
+  _server = std::thread(&TLSSocketLoopback::serve, this, fds[1]);
+  return 1;
+}
+
+size_t TLSSocketLoopback::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t TLSSocketLoopback::write(const uint8_t * buf, size_t size)
+{
+  size_t written = 0;
+
+  while (_fd >= 0 && written < size)
+  {
+    ssize_t const result = ::send(_fd, buf + written, size - written, MSG_NOSIGNAL);
+    if (result <= 0)
+      break;
+    written += result;
+  }
+
+  return written;
+}
+
+int TLSSocketLoopback::available()
+{
+  int len = 0;
+  if (_fd < 0 || ioctl(_fd, FIONREAD, &len) < 0)
+    return 0;
+  return len;
+}
+
+int TLSSocketLoopback::read()
+{
+  uint8_t b;
+  return (read(&b, 1) == 1) ? b : -1;
+}
+
+int TLSSocketLoopback::read(uint8_t * buf, size_t size)
+{
+  if (_fd < 0 || _peer_closed)
+    return -1;
+
+  /* Wait for the server thread instead of spinning against it */
+  struct pollfd pfd = {_fd, POLLIN, 0};
+  if (poll(&pfd, 1, READ_TIMEOUT_ms) <= 0)
+    return -1;
+
+  ssize_t const result = ::recv(_fd, buf, size, 0);
+  if (result <= 0) {
+    _peer_closed = true;
+    return -1;
+  }
+  return result;
+}
+
+int TLSSocketLoopback::peek()
+{
+  return -1;
+}
+
+void TLSSocketLoopback::flush()
+{
+
+}
+
+void TLSSocketLoopback::stop()
+{
+  if (_fd >= 0) {
+    shutdown(_fd, SHUT_RDWR);
+    close(_fd);
+    _fd = -1;
+  }
+
+  if (_server.joinable())
+    _server.join();
+}
+
+uint8_t TLSSocketLoopback::connected()
+{
+  return (_fd >= 0) && !_peer_closed;
+}
+
+TLSSocketLoopback::operator bool()
+{
+  return _fd >= 0;
+}
+
+/**************************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void TLSSocketLoopback::serve(int const fd)
+{
+  br_ssl_server_context sc;
+  br_sslio_context ioc;
+  std::vector<unsigned char> iobuf(BR_SSL_BUFSIZE_BIDI);
+  std::vector<unsigned char> data(16384, 0x55);
+
+  br_ssl_server_init_full_ec(&sc, &_chain, 1, BR_KEYTYPE_EC, &_sk);
+  br_ssl_engine_set_buffer(&sc.eng, iobuf.data(), iobuf.size(), 1);
+  br_ssl_engine_inject_entropy(&sc.eng, "TLSSocketLoopback", 17);
+  br_ssl_server_reset(&sc);
+
+  _server_fd = fd;
+  br_sslio_init(&ioc, &sc.eng, serverRead, this, serverWrite, this);
+
+  if (_mode == Mode::Source) {
+    /* The client tells how many bytes it wants */
+    uint32_t size = 0;
+    if (br_sslio_read_all(&ioc, &size, sizeof(size)) == 0) {
+      _suite = sc.eng.session.cipher_suite;
+      while (size > 0) {
+        size_t const len = size < data.size() ? size : data.size();
+        if (br_sslio_write_all(&ioc, data.data(), len) < 0)
+          break;
+        size -= len;
+      }
+      br_sslio_flush(&ioc);
+    }
+  } else {
+    size_t received = 0;
+    for (;;) {
+      int const len = br_sslio_read(&ioc, data.data(), data.size());
+      if (len < 0)
+        break;
+      _suite = sc.eng.session.cipher_suite;
+      received += len;
+      if (received >= _block_size) {
+        received -= _block_size;
+        unsigned char const ack = 0x06;
+        br_sslio_write_all(&ioc, &ack, 1);
+        br_sslio_flush(&ioc);
+      }
+    }
+  }
+
+  /* Let the client close the connection */
+  unsigned char b;
+  while (br_sslio_read(&ioc, &b, 1) > 0) { }
+  close(fd);
+}
+
+void TLSSocketLoopback::countRecords(unsigned char const * buf, size_t len)
+{
+  _wire_bytes += len;
+
+  while (len > 0)
+  {
+    if (_record_left > 0) {
+      size_t const skip = len < _record_left ? len : _record_left;
+      _record_left -= skip;
+      buf += skip;
+      len -= skip;
+      continue;
+    }
+
+    _header[_header_len++] = *buf++;
+    len--;
+    if (_header_len == sizeof(_header)) {
+      /* Content type 23 is application data */
+      if (_header[0] == 23)
+        _record_count++;
+      _record_left = (static_cast<size_t>(_header[3]) << 8) | _header[4];
+      _header_len = 0;
+    }
+  }
+}
+
+int TLSSocketLoopback::serverRead(void * ctx, unsigned char * buf, size_t len)
+{
+  TLSSocketLoopback * loopback = static_cast<TLSSocketLoopback *>(ctx);
+  ssize_t const result = ::recv(loopback->_server_fd, buf, len, 0);
+  if (result <= 0)
+    return -1;
+
+  loopback->countRecords(buf, result);
+  return result;
+}
+
+int TLSSocketLoopback::serverWrite(void * ctx, unsigned char const * buf, size_t len)
+{
+  TLSSocketLoopback * loopback = static_cast<TLSSocketLoopback *>(ctx);
+  ssize_t const result = ::send(loopback->_server_fd, buf, len, MSG_NOSIGNAL);
+  return (result <= 0) ? -1 : result;
+}
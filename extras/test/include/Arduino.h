@@ -10,6 +10,9 @@
  ******************************************************************************/
 
 #include <string>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 /******************************************************************************
    DEFINES
@@ -23,6 +26,7 @@
  ******************************************************************************/
 
 typedef std::string String;
+typedef uint8_t     byte;
 
 /******************************************************************************
    FUNCTION PROTOTYPES
@@ -30,5 +34,7 @@ typedef std::string String;
 
 void          set_millis(unsigned long const millis);
 unsigned long millis();
+unsigned long micros();
+long          random(long const min, long const max);
 
 #endif /* TEST_ARDUINO_H_ */
@@ -0,0 +1,31 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_ARDUINO_ECCX08_H_
+#define TEST_ARDUINO_ECCX08_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* No secure element on the host, BearSSLClient falls back to software crypto */
+class ECCX08Class
+{
+public:
+  int begin() { return 0; }
+  int locked() { return 0; }
+  int random(byte[], size_t) { return 0; }
+  int ecSign(int, const byte[], byte[]) { return 0; }
+  int ecdsaVerify(const byte[], const byte[], const byte[]) { return 0; }
+};
+
+extern ECCX08Class ECCX08;
+
+#endif /* TEST_ARDUINO_ECCX08_H_ */
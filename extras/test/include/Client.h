@@ -0,0 +1,43 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_CLIENT_H_
+#define TEST_CLIENT_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class IPAddress { };
+
+class Print
+{
+public:
+  virtual ~Print() { }
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t * buf, size_t size) = 0;
+};
+
+class Client : public Print
+{
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char * host, uint16_t port) = 0;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int read(uint8_t * buf, size_t size) = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+};
+
+#endif /* TEST_CLIENT_H_ */
@@ -24,7 +24,7 @@ namespace cbor
    PROTOTYPES
  **************************************************************************************/
 
-std::vector<uint8_t> encode(PropertyContainer & property_container, bool lightPayload = false);
+std::vector<uint8_t> encode(PropertyContainer & property_container, bool lightPayload = false, bool compactRecords = false);
 void print(std::vector<uint8_t> const & vect);
 
 /**************************************************************************************
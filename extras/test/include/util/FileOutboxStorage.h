@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+#ifndef FILE_OUTBOX_STORAGE_H_
+#define FILE_OUTBOX_STORAGE_H_
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <interfaces/OutboxStorage.h>
+
+/**************************************************************************************
+   CLASS DECLARATION
+ **************************************************************************************/
+
+/* Host OutboxStorage emulating a NOR flash with a file, so that its content survives
+ * the destruction of the outbox as it would survive a reset on a board.
+ */
+class FileOutboxStorage : public OutboxStorage
+{
+public:
+
+  FileOutboxStorage(std::string const & path, size_t const sector_size, size_t const sector_count);
+  virtual ~FileOutboxStorage();
+
+  virtual size_t sectorSize() const override { return _sector_size; }
+  virtual size_t sectorCount() const override { return _sector_count; }
+  virtual bool read(size_t const address, uint8_t * data, size_t const len) override;
+  virtual bool write(size_t const address, uint8_t const * data, size_t const len) override;
+  virtual bool erase(size_t const sector) override;
+
+  /* Stop programming after the given number of bytes, emulating a reset in the middle of a write */
+  inline void failAfter(size_t const bytes) { _write_budget = bytes; _write_limited = true; }
+  inline unsigned long getEraseCount(size_t const sector) const { return _erase_count[sector]; }
+
+private:
+
+  std::FILE * _file;
+  size_t _sector_size;
+  size_t _sector_count;
+  std::vector<unsigned long> _erase_count;
+  size_t _write_budget;
+  bool _write_limited;
+};
+
+#endif /* FILE_OUTBOX_STORAGE_H_ */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+#ifndef TLS_LOOPBACK_H_
+#define TLS_LOOPBACK_H_
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include <Client.h>
+#include <tls/bearssl/bearssl.h>
+
+/**************************************************************************************
+   CLASS DECLARATION
+ **************************************************************************************/
+
+/* Host Client connecting a BearSSLClient to a BearSSL server running in the same
+ * process. The server is driven synchronously by the bytes written by the client
+ * and echoes back the application data it receives when the client reads.
+ */
+class TLSLoopback : public Client
+{
+public:
+
+  TLSLoopback(size_t const chain_size = 512);
+
+  /* BearSSLClient profile: the library client profile, validating the loopback
+   * server with its public key instead of a certificate chain.
+   */
+  static void clientProfile(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num);
+  static unsigned long getTime();
+
+  /* Behave like a server ignoring the max_fragment_length extension: once the
+   * handshake is over the application records can be up to 16 KB.
+   */
+  inline void ignoreMaxFragmentLength(bool const ignore) { _ignore_max_fragment_length = ignore; }
+  /* Replace the server key, as when the server certificate is renewed */
+  void changeKey();
+  inline br_ec_public_key const & getPublicKey() const { return _pk; }
+  /* Fragment length the server is allowed to send after the negotiation */
+  inline size_t getMaxFragmentLength() const { return _sc.eng.max_frag_len; }
+  inline unsigned int getHandshakeCount() const { return _handshake_count; }
+  inline uint16_t getCipherSuite() const { return _sc.eng.session.cipher_suite; }
+  /* Time spent running the server engine, included in the duration of the client calls */
+  inline std::chrono::nanoseconds getServerTime() const { return _server_time; }
+  /* Application data records received from the client */
+  inline unsigned int getRecordCount() const { return _record_count; }
+
+  virtual int connect(IPAddress ip, uint16_t port) override;
+  virtual int connect(const char * host, uint16_t port) override;
+  virtual size_t write(uint8_t b) override;
+  virtual size_t write(const uint8_t * buf, size_t size) override;
+  virtual int available() override;
+  virtual int read() override;
+  virtual int read(uint8_t * buf, size_t size) override;
+  virtual int peek() override;
+  virtual void flush() override;
+  virtual void stop() override;
+  virtual uint8_t connected() override;
+  virtual operator bool() override;
+
+private:
+
+  br_ssl_server_context _sc;
+  br_ssl_session_cache_lru _cache;
+  unsigned char _cache_buf[1024];
+  unsigned char _buf[BR_SSL_BUFSIZE_BIDI];
+  br_hmac_drbg_context _rng;
+  br_ec_private_key _sk;
+  unsigned char _sk_buf[BR_EC_KBUF_PRIV_MAX_SIZE];
+  br_ec_public_key _pk;
+  unsigned char _pk_buf[BR_EC_KBUF_PUB_MAX_SIZE];
+  std::vector<unsigned char> _chain_data;
+  br_x509_certificate _chain;
+
+  std::deque<uint8_t> _rx;
+  std::vector<uint8_t> _echo;
+  bool _connected;
+  bool _established;
+  bool _ignore_max_fragment_length;
+  unsigned int _handshake_count;
+  unsigned int _record_count;
+  std::chrono::nanoseconds _server_time;
+
+  /* The data is echoed once the client reads, in records as large as allowed */
+  void service(bool const echo);
+  void serviceEngine(bool const echo);
+};
+
+#endif /* TLS_LOOPBACK_H_ */
@@ -6,7 +6,10 @@
    INCLUDE
  ******************************************************************************/
 
+#include <chrono>
+
 #include <Arduino.h>
+#include <ArduinoECCX08.h>
 
 /******************************************************************************
    GLOBAL VARIABLES
@@ -14,6 +17,8 @@
 
 static unsigned long current_millis = 0;
 
+ECCX08Class ECCX08;
+
 /******************************************************************************
    PUBLIC FUNCTIONS
  ******************************************************************************/
@@ -27,3 +32,15 @@ unsigned long millis()
 {
   return current_millis;
 }
+
+unsigned long micros()
+{
+  /* Free running, the tests only drive millis() */
+  static auto const start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+long random(long const min, long const max)
+{
+  return min + rand() % (max - min);
+}
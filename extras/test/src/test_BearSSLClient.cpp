@@ -0,0 +1,566 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <vector>
+
+#include <util/TLSLoopback.h>
+#include <tls/BearSSLClient.h>
+#include <tls/profile/aiotc_profile.h>
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static bool echo(BearSSLClient & client, size_t const size)
+{
+  std::vector<uint8_t> out(size), in(size);
+  for (size_t i = 0; i < size; i++)
+    out[i] = static_cast<uint8_t>(i * 7);
+
+  if (client.write(out.data(), size) != size)
+    return false;
+
+  size_t received = 0;
+  while (received < size) {
+    int const result = client.read(in.data() + received, size - received);
+    if (result <= 0)
+      return false;
+    received += result;
+  }
+
+  return in == out;
+}
+
+static bool isPinned(BearSSLClient & client, br_ec_public_key const & pk)
+{
+  br_ec_public_key pinned;
+  return client.getPinnedKey(pinned) && (pinned.curve == pk.curve) && (pinned.qlen == pk.qlen) &&
+         (memcmp(pinned.q, pk.q, pk.qlen) == 0);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("BearSSLClient reports the errors of the connections without buffers of their own", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback(3000);
+  BearSSLClient * client = new BearSSLClient();
+  TLSBufferPool pool(BR_SSL_BUFSIZE_INPUT, BR_SSL_BUFSIZE_OUTPUT);
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+
+  /************************************************************************************/
+
+  WHEN("No buffers are set")
+  {
+    THEN("The connection fails with an error")
+    {
+      REQUIRE(client->connect("loopback", 443) == 0);
+      REQUIRE(client->errorCode() == BR_ERR_BAD_PARAM);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The handshake of a client borrowing its buffers fails")
+  {
+    client->setBufferPool(pool);
+    client->setSessionResumption(false);
+    client->setKeyPinning(true);
+    REQUIRE(client->connect("loopback", 443) == 1);
+    client->stop();
+    server->changeKey();
+    REQUIRE(client->connect("loopback", 443) == 0);
+
+    THEN("The buffers are given back and the engine error is still reported")
+    {
+      REQUIRE_FALSE(pool.isLent());
+      REQUIRE(client->errorCode() != BR_ERR_OK);
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient negotiates the max fragment length with a loopback server", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback(3000);
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+
+  /************************************************************************************/
+
+  WHEN("The whole buffers are used")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The full fragment length is used")
+    {
+      REQUIRE(server->getMaxFragmentLength() == 16384);
+      REQUIRE(echo(*client, 4096));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The low memory mode is enabled")
+  {
+    client->setMaxFragmentLength(1024);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The server sends smaller records and the data goes through")
+    {
+      REQUIRE(server->getMaxFragmentLength() == 1024);
+      REQUIRE(echo(*client, 4096));
+      REQUIRE(client->isMaxFragmentLengthFallback() == false);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The low memory mode is enabled with a single half duplex buffer")
+  {
+    client->setBuffers(ibuf.data(), 512 + BR_SSL_BUFSIZE_INPUT - 16384, nullptr, 0);
+    client->setMaxFragmentLength(512, true);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The data goes through a buffer smaller than the server certificate")
+    {
+      REQUIRE(server->getMaxFragmentLength() == 512);
+      REQUIRE(echo(*client, 2000));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The server ignores the max fragment length")
+  {
+    server->ignoreMaxFragmentLength(true);
+    client->setMaxFragmentLength(1024);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("A larger record breaks the connection")
+    {
+      REQUIRE_FALSE(echo(*client, 4096));
+      client->stop();
+      REQUIRE(client->isMaxFragmentLengthFallback() == true);
+
+      AND_THEN("The next connection falls back to the whole buffers")
+      {
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(server->getMaxFragmentLength() == 16384);
+        REQUIRE(echo(*client, 4096));
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient coalesces the corked writes", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback();
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+  uint8_t const header[] = {0x30, 0x20};
+  uint8_t const topic[]  = {0x00, 0x05, '/', 'a', '/', 't', '/'};
+  uint8_t const payload[20] = {0};
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  REQUIRE(client->connect("loopback", 443) == 1);
+  unsigned int const records = server->getRecordCount();
+
+  /************************************************************************************/
+
+  WHEN("A packet is written in pieces")
+  {
+    client->write(header, sizeof(header));
+    client->write(topic, sizeof(topic));
+    client->write(payload, sizeof(payload));
+
+    THEN("Each piece is sent in its own record")
+    {
+      REQUIRE(server->getRecordCount() == records + 3);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A packet is written in pieces while corked")
+  {
+    client->cork();
+    client->write(header, sizeof(header));
+    client->cork();
+    client->write(topic, sizeof(topic));
+    client->write(payload, sizeof(payload));
+    REQUIRE(client->uncork() == 1);
+    REQUIRE(server->getRecordCount() == records);
+    REQUIRE(client->uncork() == 1);
+
+    THEN("The last uncork sends the whole packet in a single record")
+    {
+      REQUIRE(server->getRecordCount() == records + 1);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("More data than a record is written while corked")
+  {
+    client->cork();
+    client->write(std::vector<uint8_t>(20000, 0x55).data(), 20000);
+
+    THEN("The full records are sent anyway")
+    {
+      REQUIRE(server->getRecordCount() == records + 1);
+      REQUIRE(client->uncork() == 1);
+      REQUIRE(server->getRecordCount() == records + 2);
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient authenticates the server with a pinned key", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback();
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  client->setSessionResumption(false);
+  client->setKeyPinning(true, 2);
+
+  /************************************************************************************/
+
+  WHEN("The first connection validates the server chain")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+    REQUIRE(client->isKeyPinned() == false);
+
+    THEN("The server key is pinned")
+    {
+      REQUIRE(isPinned(*client, server->getPublicKey()));
+
+      AND_THEN("The next connections use the pinned key until a full validation is due")
+      {
+        client->stop();
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isKeyPinned() == true);
+        client->stop();
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isKeyPinned() == true);
+        client->stop();
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isKeyPinned() == false);
+        client->stop();
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isKeyPinned() == true);
+        REQUIRE(echo(*client, 100));
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The server key changes")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+    client->stop();
+    server->changeKey();
+
+    THEN("The pinned handshake fails")
+    {
+      REQUIRE(client->connect("loopback", 443) == 0);
+      REQUIRE(client->isKeyPinned() == true);
+
+      AND_THEN("The next connection validates the chain and pins the new key")
+      {
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isKeyPinned() == false);
+        REQUIRE(isPinned(*client, server->getPublicKey()));
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The key pinning is disabled")
+  {
+    client->setKeyPinning(false);
+    REQUIRE(client->connect("loopback", 443) == 1);
+    client->stop();
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The chain is always validated")
+    {
+      REQUIRE(client->isKeyPinned() == false);
+      br_ec_public_key pinned;
+      REQUIRE(client->getPinnedKey(pinned) == false);
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient uses a precomputed ECDHE key share", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback();
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  client->setSessionResumption(false);
+
+  /* The key share is computed on the curve chosen by the server in the last handshake */
+  REQUIRE(client->connect("loopback", 443) == 1);
+  client->stop();
+  client->setSessionResumption(true);
+  BearSSLClient::clearKeyShare();
+
+  /************************************************************************************/
+
+  WHEN("A key share is precomputed before a full handshake")
+  {
+    REQUIRE(BearSSLClient::precomputeKeyShare() == true);
+    REQUIRE(BearSSLClient::hasKeyShare() == true);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The handshake uses it and the connection works")
+    {
+      REQUIRE(BearSSLClient::hasKeyShare() == false);
+      REQUIRE(echo(*client, 100));
+
+      AND_THEN("A resumed handshake leaves the next key share untouched")
+      {
+        client->stop();
+        REQUIRE(BearSSLClient::precomputeKeyShare() == true);
+        REQUIRE(client->connect("loopback", 443) == 1);
+        REQUIRE(client->isSessionResumed() == true);
+        REQUIRE(BearSSLClient::hasKeyShare() == true);
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("No key share is precomputed")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("The engine computes its own one")
+    {
+      REQUIRE(BearSSLClient::hasKeyShare() == false);
+      REQUIRE(echo(*client, 100));
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  BearSSLClient::clearKeyShare();
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient negotiates the cipher suites of the profile configuration", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback();
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+  aiotc_profile_config config;
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  /* A resumed session keeps the suite of the previous one */
+  client->setSessionResumption(false);
+
+  /************************************************************************************/
+
+  WHEN("The profile is not configured")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("AES-128/GCM is negotiated")
+    {
+      REQUIRE(server->getCipherSuite() == BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256);
+      REQUIRE(echo(*client, 100));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("ChaCha20-Poly1305 is preferred")
+  {
+    static uint16_t const suites[] = {
+      BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+      BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+    };
+    aiotc_client_profile_defaults(&config);
+    config.suites = suites;
+    config.suites_num = 2;
+    aiotc_client_profile_configure(&config);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("ChaCha20-Poly1305 is negotiated")
+    {
+      REQUIRE(server->getCipherSuite() == BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256);
+      REQUIRE(echo(*client, 100));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The AES and GHASH implementations of a Cortex-M are selected")
+  {
+    memset(&config, 0, sizeof(config));
+    config.aes_ctr = &br_aes_ct_ctr_vtable;
+    config.ghash = &br_ghash_ctmul32;
+    aiotc_client_profile_configure(&config);
+    REQUIRE(client->connect("loopback", 443) == 1);
+
+    THEN("AES-128/GCM is negotiated and the connection works")
+    {
+      REQUIRE(server->getCipherSuite() == BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256);
+      REQUIRE(echo(*client, 1000));
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  aiotc_client_profile_configure(NULL);
+  delete client;
+  delete server;
+}
+
+SCENARIO("BearSSLClient profiles the phases of the handshake", "[BearSSLClient]")
+{
+  TLSLoopback * server = new TLSLoopback(3000);
+  BearSSLClient * client = new BearSSLClient();
+  std::vector<unsigned char> ibuf(BR_SSL_BUFSIZE_INPUT), obuf(BR_SSL_BUFSIZE_OUTPUT);
+
+  client->setClient(*server);
+  client->setProfile(TLSLoopback::clientProfile);
+  client->onGetTime(TLSLoopback::getTime);
+  client->setBuffers(ibuf.data(), ibuf.size(), obuf.data(), obuf.size());
+  client->clearSession();
+
+  /************************************************************************************/
+
+  WHEN("A full handshake is done")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+    BearSSLClient::HandshakeProfile const profile = client->getHandshakeProfile();
+
+    THEN("The four flights are recorded")
+    {
+      REQUIRE(profile.established == true);
+      REQUIRE(profile.clientHelloBytes > 0);
+      /* The server flight carries its certificate chain */
+      REQUIRE(profile.serverHelloBytes > 3000);
+      REQUIRE(profile.clientFinishedBytes > 0);
+      REQUIRE(profile.serverFinishedBytes > 0);
+      REQUIRE(profile.keyExchange > 0);
+      REQUIRE(profile.tcpConnect + profile.clientHello + profile.serverHello + profile.clientFinished + profile.serverFinished <= profile.total);
+      REQUIRE(profile.keyExchange <= profile.clientFinished);
+
+      AND_THEN("The application data is not recorded")
+      {
+        REQUIRE(echo(*client, 100));
+        REQUIRE(client->getHandshakeProfile().clientFinishedBytes == profile.clientFinishedBytes);
+        REQUIRE(client->getHandshakeProfile().serverFinishedBytes == profile.serverFinishedBytes);
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The session is resumed")
+  {
+    REQUIRE(client->connect("loopback", 443) == 1);
+    client->stop();
+    REQUIRE(client->connect("loopback", 443) == 1);
+    REQUIRE(client->isSessionResumed() == true);
+    BearSSLClient::HandshakeProfile const profile = client->getHandshakeProfile();
+
+    THEN("The handshake ends with the client Finished, without key exchange")
+    {
+      REQUIRE(profile.established == true);
+      REQUIRE(profile.serverHelloBytes > 0);
+      REQUIRE(profile.serverHelloBytes < 3000);
+      REQUIRE(profile.clientFinishedBytes > 0);
+      REQUIRE(profile.serverFinishedBytes == 0);
+      REQUIRE(profile.keyExchange == 0);
+      REQUIRE(profile.certValidation == 0);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The handshake fails")
+  {
+    server->changeKey();
+    client->setSessionResumption(false);
+    client->setKeyPinning(true);
+    REQUIRE(client->connect("loopback", 443) == 1);
+    client->stop();
+    server->changeKey();
+    REQUIRE(client->connect("loopback", 443) == 0);
+
+    THEN("The profile reports it")
+    {
+      REQUIRE(client->getHandshakeProfile().established == false);
+      REQUIRE(client->getHandshakeProfile().serverHelloBytes > 0);
+      REQUIRE(client->getHandshakeProfile().total > 0);
+    }
+  }
+
+  /************************************************************************************/
+
+  client->stop();
+  delete client;
+  delete server;
+}
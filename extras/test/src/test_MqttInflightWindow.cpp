@@ -0,0 +1,163 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <vector>
+
+#include <utility/mqtt/MqttPacketScanner.h>
+#include <utility/mqtt/MqttInflightWindow.h>
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+struct PacketId
+{
+  MqttPacketType type;
+  uint16_t packet_id;
+
+  bool operator == (PacketId const & other) const { return (type == other.type) && (packet_id == other.packet_id); }
+};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("MQTT packet identifiers are tracked on a byte stream", "[MqttPacketScanner]")
+{
+  MqttPacketScanner scanner;
+  std::vector<PacketId> found;
+  OnMqttPacketId const on_packet_id = [&found](MqttPacketType const type, uint16_t const packet_id) { found.push_back({type, packet_id}); };
+
+  /* PUBLISH QoS 1 "a/b" id 0x1234 payload "xy", PUBACK id 0x0001, PINGRESP, PUBLISH QoS 0 "t" payload "z", PUBACK id 0x0102 */
+  std::vector<uint8_t> const stream = {
+    0x32, 0x09, 0x00, 0x03, 'a', '/', 'b', 0x12, 0x34, 'x', 'y',
+    0x40, 0x02, 0x00, 0x01,
+    0xD0, 0x00,
+    0x30, 0x04, 0x00, 0x01, 't', 'z',
+    0x40, 0x02, 0x01, 0x02
+  };
+  std::vector<PacketId> const expected = {
+    {MqttPacketType::Publish, 0x1234},
+    {MqttPacketType::PubAck,  0x0001},
+    {MqttPacketType::PubAck,  0x0102}
+  };
+
+  WHEN("The stream is fed at once")
+  {
+    scanner.feed(stream.data(), stream.size(), on_packet_id);
+    THEN("Every packet identifier is reported in order")
+    {
+      REQUIRE(found == expected);
+    }
+  }
+
+  WHEN("The stream is fed one byte at a time")
+  {
+    for (uint8_t const b : stream)
+      scanner.feed(&b, 1, on_packet_id);
+    THEN("Every packet identifier is reported in order")
+    {
+      REQUIRE(found == expected);
+    }
+  }
+
+  WHEN("A packet has a multi byte remaining length")
+  {
+    /* PUBLISH QoS 1 "t" id 0x00AA with a 200 bytes payload, remaining length 205 = CD 01 */
+    std::vector<uint8_t> publish = {0x32, 0xCD, 0x01, 0x00, 0x01, 't', 0x00, 0xAA};
+    publish.insert(publish.end(), 200, 0x40);
+    publish.insert(publish.end(), {0x40, 0x02, 0x00, 0xAA});
+    scanner.feed(publish.data(), publish.size(), on_packet_id);
+    THEN("The payload is skipped and the following packet is found")
+    {
+      REQUIRE(found == std::vector<PacketId>{{MqttPacketType::Publish, 0x00AA}, {MqttPacketType::PubAck, 0x00AA}});
+    }
+  }
+
+  WHEN("A CONNACK is received")
+  {
+    /* CONNACK session present, accepted */
+    std::vector<uint8_t> const connack = {0x20, 0x02, 0x01, 0x00, 0x40, 0x02, 0x00, 0x01};
+    scanner.feed(connack.data(), connack.size(), on_packet_id);
+    THEN("Its acknowledge flags and return code are reported")
+    {
+      REQUIRE(found == std::vector<PacketId>{{MqttPacketType::ConnAck, 0x0100}, {MqttPacketType::PubAck, 0x0001}});
+    }
+  }
+}
+
+SCENARIO("QoS 1 messages are kept until acknowledged", "[MqttInflightWindow]")
+{
+  MqttInflightWindow window(2, 8);
+  uint8_t const a[] = {'a'};
+  uint8_t const b[] = {'b', 'b'};
+
+  WHEN("Messages are added up to the window size")
+  {
+    REQUIRE(window.add(1, a, sizeof(a)));
+    REQUIRE(window.add(2, b, sizeof(b)));
+
+    THEN("The window is full until one of them is acknowledged")
+    {
+      REQUIRE(window.isFull());
+      REQUIRE_FALSE(window.add(3, a, sizeof(a)));
+      REQUIRE_FALSE(window.acknowledge(3));
+      REQUIRE(window.acknowledge(2));
+      REQUIRE(window.count() == 1);
+      REQUIRE(window.add(3, a, sizeof(a)));
+    }
+  }
+
+  WHEN("The connection is lost with messages not acknowledged")
+  {
+    REQUIRE(window.add(7, b, sizeof(b)));
+    REQUIRE(window.add(5, a, sizeof(a)));
+    window.expire();
+
+    THEN("Acknowledgements of the old session are ignored")
+    {
+      REQUIRE_FALSE(window.acknowledge(7));
+      REQUIRE(window.hasExpired());
+    }
+
+    THEN("Messages are resent oldest first with new packet identifiers")
+    {
+      std::vector<std::vector<uint8_t>> resent;
+      uint16_t next_id = 1;
+      size_t const left = window.resend([&](uint16_t & packet_id, uint8_t const * data, size_t const length)
+      {
+        resent.push_back(std::vector<uint8_t>(data, data + length));
+        packet_id = next_id++;
+        return true;
+      });
+      REQUIRE(left == 0);
+      REQUIRE(resent == std::vector<std::vector<uint8_t>>{{'b', 'b'}, {'a'}});
+      REQUIRE(window.acknowledge(1));
+      REQUIRE(window.acknowledge(2));
+      REQUIRE(window.isEmpty());
+    }
+
+    THEN("Resending stops at the first failure and restarts from there")
+    {
+      REQUIRE(window.resend([](uint16_t &, uint8_t const *, size_t const) { return false; }) == 2);
+      std::vector<uint8_t> first;
+      window.resend([&](uint16_t & packet_id, uint8_t const * data, size_t const length)
+      {
+        if (!first.empty())
+          return false;
+        first.assign(data, data + length);
+        packet_id = 9;
+        return true;
+      });
+      REQUIRE(first == std::vector<uint8_t>{'b', 'b'});
+      REQUIRE(window.hasExpired());
+    }
+  }
+}
@@ -0,0 +1,249 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <cstdio>
+
+#include <util/CBORTestUtil.h>
+#include <util/FileOutboxStorage.h>
+#include <PersistentOutbox.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static char const   STORAGE_FILE[] = "test_PersistentOutbox.bin";
+static size_t const SECTOR_SIZE    = 128;
+static size_t const SECTOR_COUNT   = 4;
+static size_t const MESSAGE_SIZE   = 64;
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static std::vector<uint8_t> drain(PersistentOutbox & outbox, size_t const size = MESSAGE_SIZE)
+{
+  uint8_t buf[MESSAGE_SIZE] = {0};
+  int bytes_encoded = 0;
+  size_t const count = outbox.encode(buf, size, bytes_encoded);
+  outbox.release(count);
+  return std::vector<uint8_t>(buf, buf + bytes_encoded);
+}
+
+static void push(PersistentOutbox & outbox, uint8_t const value)
+{
+  /* Each entry is a CBOR small unsigned integer */
+  REQUIRE(outbox.push(&value, 1));
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Property updates are kept into a persistent outbox", "[PersistentOutbox]")
+{
+  std::remove(STORAGE_FILE);
+
+  /************************************************************************************/
+
+  WHEN("A property changes several times while offline")
+  {
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+
+    PropertyContainer property_container;
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite);
+
+    set_millis(0);
+    outbox.record(property_container, 1000);
+    int_test = 2;
+    set_millis(1000);
+    outbox.record(property_container, 1001);
+
+    THEN("Every snapshot is replayed in the order it was recorded")
+    {
+      REQUIRE(outbox.count() == 2);
+      /* [{0: "t", 2: 1, 6: 1000}, {0: "t", 2: 2, 6: 1001}] */
+      std::vector<uint8_t> const expected = {0x9F,
+                                             0xA3, 0x00, 0x61, 0x74, 0x02, 0x01, 0x06, 0x19, 0x03, 0xE8,
+                                             0xA3, 0x00, 0x61, 0x74, 0x02, 0x02, 0x06, 0x19, 0x03, 0xE9,
+                                             0xFF};
+      REQUIRE(drain(outbox) == expected);
+      REQUIRE(outbox.isEmpty());
+    }
+
+    THEN("The recorded updates are not sent again by the regular encoder")
+    {
+      REQUIRE(cbor::encode(property_container).empty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The device is reset while snapshots are queued")
+  {
+    {
+      FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+      PersistentOutbox outbox(MESSAGE_SIZE);
+      REQUIRE(outbox.begin(storage));
+      push(outbox, 1);
+      push(outbox, 2);
+      push(outbox, 3);
+      REQUIRE(drain(outbox, 4) == std::vector<uint8_t>{0x9F, 0x01, 0x02, 0xFF});
+    }
+
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+
+    THEN("Only the snapshots not yet delivered are recovered")
+    {
+      REQUIRE(outbox.count() == 1);
+      push(outbox, 4);
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x03, 0x04, 0xFF});
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The device is reset in the middle of a write")
+  {
+    {
+      FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+      PersistentOutbox outbox(MESSAGE_SIZE);
+      REQUIRE(outbox.begin(storage));
+      push(outbox, 1);
+      storage.failAfter(3);
+      uint8_t const value = 2;
+      REQUIRE_FALSE(outbox.push(&value, 1));
+    }
+
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+
+    THEN("The torn entry is ignored and the log keeps growing after it")
+    {
+      REQUIRE(outbox.count() == 1);
+      push(outbox, 3);
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x01, 0x03, 0xFF});
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("An entry is corrupted in the storage")
+  {
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+    push(outbox, 1);
+    push(outbox, 2);
+    push(outbox, 3);
+
+    /* The record of the second entry follows the sector header and the first entry */
+    uint8_t const zero = 0;
+    REQUIRE(storage.write(8 + 5 + 4, &zero, 1));
+
+    THEN("The entries before it are delivered and the corrupted one is dropped instead of blocking the log")
+    {
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x01, 0xFF});
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x03, 0xFF});
+      REQUIRE(outbox.isEmpty());
+      REQUIRE(outbox.getDroppedCount() == 1);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Entries are stored and delivered for a long time")
+  {
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+
+    for (unsigned int i = 0; i < 10000; i++)
+    {
+      push(outbox, static_cast<uint8_t>(i % 24));
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, static_cast<uint8_t>(i % 24), 0xFF});
+    }
+
+    THEN("The sectors are erased evenly")
+    {
+      unsigned long min_erase = storage.getEraseCount(0), max_erase = storage.getEraseCount(0);
+      for (size_t s = 1; s < SECTOR_COUNT; s++)
+      {
+        min_erase = std::min(min_erase, storage.getEraseCount(s));
+        max_erase = std::max(max_erase, storage.getEraseCount(s));
+      }
+      REQUIRE(min_erase > 0);
+      REQUIRE((max_erase - min_erase) <= 1);
+      REQUIRE(outbox.getDroppedCount() == 0);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("More entries are stored than the storage can hold")
+  {
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    REQUIRE(outbox.begin(storage));
+
+    for (unsigned int i = 0; i < 200; i++)
+      push(outbox, static_cast<uint8_t>(i % 24));
+
+    THEN("The oldest entries are dropped and the newest ones are kept in order")
+    {
+      REQUIRE(outbox.getDroppedCount() > 0);
+      REQUIRE((outbox.count() + outbox.getDroppedCount()) == 200);
+
+      unsigned int expected = static_cast<unsigned int>(outbox.getDroppedCount());
+      while (!outbox.isEmpty())
+      {
+        std::vector<uint8_t> const message = drain(outbox);
+        REQUIRE(message.size() > 2);
+        for (size_t i = 1; i < message.size() - 1; i++, expected++)
+          REQUIRE(message[i] == (expected % 24));
+      }
+      REQUIRE(expected == 200);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A bandwidth limit is set")
+  {
+    FileOutboxStorage storage(STORAGE_FILE, SECTOR_SIZE, SECTOR_COUNT);
+    PersistentOutbox outbox(MESSAGE_SIZE);
+    set_millis(0);
+    REQUIRE(outbox.begin(storage));
+    outbox.setBandwidthLimit(4);
+    for (uint8_t i = 0; i < 10; i++)
+      push(outbox, i);
+
+    THEN("The replay does not exceed the limit")
+    {
+      REQUIRE(drain(outbox).empty());
+      set_millis(1000);
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x00, 0x01, 0xFF});
+      REQUIRE(drain(outbox).empty());
+      set_millis(1500);
+      REQUIRE(drain(outbox).empty());
+      set_millis(2000);
+      REQUIRE(drain(outbox) == std::vector<uint8_t>{0x9F, 0x02, 0x03, 0xFF});
+    }
+  }
+
+  /************************************************************************************/
+
+  std::remove(STORAGE_FILE);
+}
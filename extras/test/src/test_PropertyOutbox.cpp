@@ -0,0 +1,251 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <PropertyOutbox.h>
+#include <CBORDecoder.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static size_t const MESSAGE_SIZE = 64;
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static std::vector<uint8_t> drain(PropertyOutbox & outbox)
+{
+  uint8_t buf[MESSAGE_SIZE] = {0};
+  int bytes_encoded = 0;
+  size_t const count = outbox.encode(buf, sizeof(buf), bytes_encoded);
+  outbox.release(count);
+  return std::vector<uint8_t>(buf, buf + bytes_encoded);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Property updates are recorded into the outbox while offline", "[PropertyOutbox]")
+{
+  /************************************************************************************/
+
+  WHEN("A 'KeepLatest' property changes several times while offline")
+  {
+    PropertyContainer property_container;
+    PropertyOutbox outbox(1024, MESSAGE_SIZE);
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite);
+
+    set_millis(0);
+    outbox.record(property_container, 1000);
+    int_test = 2;
+    set_millis(1000);
+    outbox.record(property_container, 1001);
+    int_test = 3;
+    set_millis(2000);
+    outbox.record(property_container, 1002);
+
+    THEN("Only the latest snapshot is kept, stamped with the time it was recorded")
+    {
+      REQUIRE(outbox.count() == 1);
+      /* [{0: "t", 2: 3, 6: 1002}] = 9F A3 00 61 74 02 03 06 19 03 EA FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x61, 0x74, 0x02, 0x03, 0x06, 0x19, 0x03, 0xEA, 0xFF};
+      REQUIRE(drain(outbox) == expected);
+      REQUIRE(outbox.isEmpty());
+    }
+
+    THEN("The recorded updates are not sent again by the regular encoder")
+    {
+      REQUIRE(cbor::encode(property_container).empty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'KeepAll' property changes several times while offline")
+  {
+    PropertyContainer property_container;
+    PropertyOutbox outbox(1024, MESSAGE_SIZE);
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite).coalescing(Coalescing::KeepAll);
+
+    set_millis(0);
+    outbox.record(property_container, 1000);
+    set_millis(1000);
+    outbox.record(property_container, 1000);
+    int_test = 2;
+    set_millis(2000);
+    outbox.record(property_container, 1001);
+
+    THEN("Every change is kept in order, unchanged values are not recorded twice")
+    {
+      REQUIRE(outbox.count() == 2);
+      /* [{0: "t", 2: 1, 6: 1000}, {0: "t", 2: 2, 6: 1001}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x61, 0x74, 0x02, 0x01, 0x06, 0x19, 0x03, 0xE8,
+                                                   0xA3, 0x00, 0x61, 0x74, 0x02, 0x02, 0x06, 0x19, 0x03, 0xE9, 0xFF};
+      REQUIRE(drain(outbox) == expected);
+    }
+
+    THEN("The property timestamp configuration is left untouched")
+    {
+      int_test = 3;
+      set_millis(3000);
+      /* [{0: "t", 2: 3}] = 9F A2 00 61 74 02 03 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x61, 0x74, 0x02, 0x03, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("More updates than the outbox capacity are recorded")
+  {
+    PropertyContainer property_container;
+    /* Each snapshot {0: "t", 2: n, 6: t} is 10 bytes long */
+    PropertyOutbox outbox(3 * (10 + PropertyOutbox::ENTRY_HEADER_SIZE), MESSAGE_SIZE);
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite).coalescing(Coalescing::KeepAll);
+
+    for (int i = 1; i <= 5; i++)
+    {
+      int_test = i;
+      set_millis(i * 1000);
+      outbox.record(property_container, 1000);
+    }
+
+    THEN("The oldest snapshots are dropped")
+    {
+      REQUIRE(outbox.count() == 3);
+      REQUIRE(outbox.bytes() == 30);
+      REQUIRE(outbox.getDroppedCount() == 2);
+
+      PropertyContainer cloud_container;
+      CloudInt cloud_int = 0;
+      addPropertyToContainer(cloud_container, cloud_int, "t", Permission::ReadWrite);
+      std::vector<uint8_t> const payload = drain(outbox);
+      CBORDecoder::decode(cloud_container, payload.data(), payload.size());
+      REQUIRE(cloud_int == 5);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'KeepLatest' property keeps changing behind a 'KeepAll' one")
+  {
+    PropertyContainer property_container;
+    /* Room for four snapshots of 10 bytes */
+    PropertyOutbox outbox(4 * (10 + PropertyOutbox::ENTRY_HEADER_SIZE), MESSAGE_SIZE);
+    CloudInt int_all = 1;
+    CloudInt int_latest = 1;
+    addPropertyToContainer(property_container, int_all, "a", Permission::ReadWrite).coalescing(Coalescing::KeepAll);
+    addPropertyToContainer(property_container, int_latest, "t", Permission::ReadWrite);
+
+    for (int i = 1; i <= 10; i++)
+    {
+      int_latest = i;
+      set_millis(i * 1000);
+      outbox.record(property_container, 1000);
+    }
+
+    THEN("The space of the replaced snapshots is reused without dropping any other")
+    {
+      REQUIRE(outbox.count() == 2);
+      REQUIRE(outbox.bytes() == 20);
+      REQUIRE(outbox.getDroppedCount() == 0);
+
+      PropertyContainer cloud_container;
+      CloudInt cloud_all = 0;
+      CloudInt cloud_latest = 0;
+      addPropertyToContainer(cloud_container, cloud_all, "a", Permission::ReadWrite);
+      addPropertyToContainer(cloud_container, cloud_latest, "t", Permission::ReadWrite);
+      std::vector<uint8_t> const payload = drain(outbox);
+      CBORDecoder::decode(cloud_container, payload.data(), payload.size());
+      REQUIRE(cloud_all == 1);
+      REQUIRE(cloud_latest == 10);
+      REQUIRE(outbox.isEmpty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The queued snapshots don't fit into a single message")
+  {
+    PropertyContainer property_container;
+    PropertyOutbox outbox(1024, MESSAGE_SIZE);
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite).coalescing(Coalescing::KeepAll);
+
+    for (int i = 1; i <= 10; i++)
+    {
+      int_test = i;
+      set_millis(i * 1000);
+      outbox.record(property_container, 1000);
+    }
+
+    THEN("They are drained over several messages, each one within the message size")
+    {
+      size_t messages = 0;
+      while (!outbox.isEmpty())
+      {
+        std::vector<uint8_t> const payload = drain(outbox);
+        REQUIRE(payload.size() > 0);
+        REQUIRE(payload.size() <= MESSAGE_SIZE);
+        messages++;
+      }
+      /* 6 snapshots of 10 bytes fit into a 64 bytes message */
+      REQUIRE(messages == 2);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A message is not delivered")
+  {
+    PropertyContainer property_container;
+    PropertyOutbox outbox(1024, MESSAGE_SIZE);
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "t", Permission::ReadWrite);
+    outbox.record(property_container, 1000);
+
+    THEN("The snapshots are kept until they are released")
+    {
+      uint8_t buf[MESSAGE_SIZE] = {0};
+      int bytes_encoded = 0;
+      REQUIRE(outbox.encode(buf, sizeof(buf), bytes_encoded) == 1);
+      REQUIRE(outbox.count() == 1);
+      REQUIRE(outbox.encode(buf, sizeof(buf), bytes_encoded) == 1);
+      outbox.release(1);
+      REQUIRE(outbox.isEmpty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A property snapshot doesn't fit into a message")
+  {
+    PropertyContainer property_container;
+    PropertyOutbox outbox(1024, MESSAGE_SIZE);
+    CloudString str_test;
+    str_test = std::string(100, 'x');
+    addPropertyToContainer(property_container, str_test, "s", Permission::ReadWrite);
+    outbox.record(property_container, 1000);
+
+    THEN("It is not recorded and left pending for the regular encoder")
+    {
+      REQUIRE(outbox.isEmpty());
+      REQUIRE(property_container.front()->shouldBeUpdated());
+    }
+  }
+
+  /************************************************************************************/
+}
@@ -0,0 +1,61 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <tls/utility/TLSBufferPool.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("TLS buffers are lent by the pool", "[TLSBufferPool]")
+{
+  TLSBufferPool pool(1024, 256);
+  unsigned char * ibuf = nullptr;
+  unsigned char * obuf = nullptr;
+
+  REQUIRE(pool.isLent() == false);
+
+  WHEN("The buffers are borrowed")
+  {
+    REQUIRE(pool.acquire(ibuf, obuf) == true);
+
+    THEN("They do not overlap and can be used whole")
+    {
+      REQUIRE(pool.isLent() == true);
+      REQUIRE(obuf == ibuf + pool.getIbufSize());
+      ibuf[pool.getIbufSize() - 1] = 0xAA;
+      obuf[pool.getObufSize() - 1] = 0x55;
+      REQUIRE(ibuf[pool.getIbufSize() - 1] == 0xAA);
+    }
+
+    THEN("They can not be borrowed again until given back")
+    {
+      unsigned char * other_ibuf = nullptr;
+      unsigned char * other_obuf = nullptr;
+      REQUIRE(pool.acquire(other_ibuf, other_obuf) == false);
+      REQUIRE(other_ibuf == nullptr);
+
+      pool.release(ibuf);
+      REQUIRE(pool.isLent() == false);
+      REQUIRE(pool.acquire(other_ibuf, other_obuf) == true);
+      pool.release(other_ibuf);
+    }
+
+    THEN("Giving back buffers not lent by the pool has no effect")
+    {
+      unsigned char foreign[16];
+      pool.release(foreign);
+      pool.release(nullptr);
+      REQUIRE(pool.isLent() == true);
+      pool.release(ibuf);
+      REQUIRE(pool.isLent() == false);
+    }
+  }
+}
@@ -12,6 +12,7 @@
 #include <AIoTC_Config.h>
 #include <Arduino.h>
 #include <limits.h>
+#include <algorithm>
 
 /******************************************************************************
    TEST CODE
@@ -184,3 +185,101 @@ SCENARIO("Test isExpired() and isRetry()")
   attempt.reset();
   REQUIRE(attempt.isRetry() == false);
 }
+
+static unsigned long constantBackoff(unsigned long minDelay, unsigned long /* maxDelay */, unsigned int /* retryCount */, unsigned long /* lastDelay */, uint32_t /* random */)
+{
+  return minDelay + 1;
+}
+
+SCENARIO("Test full jitter backoff policy")
+{
+  TimedAttempt attempt(0,0);
+  attempt.setBackoffPolicy(TimedAttempt::fullJitterBackoff, 42);
+
+  attempt.begin(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms,
+                AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+
+  unsigned long lowest = ULONG_MAX;
+  unsigned long highest = 0;
+
+  while(attempt.getRetryCount() < 1000) {
+    attempt.retry();
+
+    unsigned long const exponential = TimedAttempt::exponentialBackoff(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms,
+                                                                       AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms,
+                                                                       attempt.getRetryCount(), 0, 0);
+    REQUIRE(attempt.getWaitTime() >= AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms / 2);
+    REQUIRE(attempt.getWaitTime() <= exponential);
+
+    lowest = min(lowest, (unsigned long)attempt.getWaitTime());
+    highest = std::max<unsigned long>(highest, attempt.getWaitTime());
+  }
+
+  /* The delays are spread over the whole interval */
+  REQUIRE(lowest < AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms);
+  REQUIRE(highest > AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms - AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms);
+}
+
+SCENARIO("Test decorrelated jitter backoff policy")
+{
+  TimedAttempt attempt(0,0);
+  attempt.setBackoffPolicy(TimedAttempt::decorrelatedJitterBackoff, 42);
+
+  attempt.begin(AIOT_CONFIG_THING_ID_REQUEST_RETRY_DELAY_ms,
+                AIOT_CONFIG_MAX_THING_ID_REQUEST_RETRY_DELAY_ms);
+
+  unsigned long last = AIOT_CONFIG_THING_ID_REQUEST_RETRY_DELAY_ms;
+
+  while(attempt.getRetryCount() < 1000) {
+    attempt.retry();
+
+    REQUIRE(attempt.getWaitTime() >= AIOT_CONFIG_THING_ID_REQUEST_RETRY_DELAY_ms / 2);
+    REQUIRE(attempt.getWaitTime() <= min(3 * last, AIOT_CONFIG_MAX_THING_ID_REQUEST_RETRY_DELAY_ms));
+
+    last = std::max<unsigned long>(attempt.getWaitTime(), AIOT_CONFIG_THING_ID_REQUEST_RETRY_DELAY_ms);
+  }
+}
+
+SCENARIO("Test backoff policy seeding")
+{
+  TimedAttempt a(0,0), b(0,0), c(0,0);
+  a.setBackoffPolicy(TimedAttempt::fullJitterBackoff, 1234);
+  b.setBackoffPolicy(TimedAttempt::fullJitterBackoff, 1234);
+  c.setBackoffPolicy(TimedAttempt::fullJitterBackoff, 5678);
+
+  a.begin(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+  b.begin(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+  c.begin(AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+
+  bool lockstep = true;
+  for (int i = 0; i < 10; i++) {
+    a.retry();
+    b.retry();
+    c.retry();
+    REQUIRE(a.getWaitTime() == b.getWaitTime());
+    lockstep = lockstep && (a.getWaitTime() == c.getWaitTime());
+  }
+
+  /* Same seed same sequence, different seeds do not retry in lockstep */
+  REQUIRE(lockstep == false);
+}
+
+SCENARIO("Test custom backoff policy")
+{
+  TimedAttempt attempt(0,0);
+  attempt.setBackoffPolicy(constantBackoff, 0);
+
+  attempt.begin(AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms);
+  attempt.retry();
+  REQUIRE(attempt.getWaitTime() == AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms + 1);
+
+  WHEN("The policy is reset")
+  {
+    attempt.setBackoffPolicy(nullptr, 0);
+    attempt.retry();
+    THEN("The exponential backoff is used")
+    {
+      REQUIRE(attempt.getWaitTime() == AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms);
+    }
+  }
+}
@@ -322,6 +322,44 @@ SCENARIO("Test the encoding of command messages") {
 
   /****************************************************************************/
 
+  WHEN("Encode a DeviceBeginCmd and a ThingBeginCmd message as a sequence")
+  {
+    DeviceBeginCmd device_begin;
+    device_begin.c.id = CommandId::DeviceBeginCmdId;
+    strcpy(device_begin.params.lib_version, "2.0.0");
+
+    ThingBeginCmd thing_begin;
+    thing_begin.c.id = CommandId::ThingBeginCmdId;
+    strcpy(thing_begin.params.thing_id, "thing_id");
+
+    uint8_t buffer[30];
+    size_t first_encoded = sizeof(buffer);
+
+    CBORMessageEncoder encoder;
+    Encoder::Status first_err = encoder.encode((Message*)&device_begin, buffer, first_encoded);
+    size_t second_encoded = sizeof(buffer) - first_encoded;
+    Encoder::Status second_err = encoder.encode((Message*)&thing_begin, buffer + first_encoded, second_encoded);
+    size_t third_encoded = sizeof(buffer) - first_encoded - second_encoded;
+    Encoder::Status third_err = encoder.encode((Message*)&thing_begin, buffer + first_encoded + second_encoded, third_encoded);
+
+    uint8_t expected_result[] = {
+      0xda, 0x00, 0x01, 0x07, 0x00, 0x81, 0x65, 0x32,
+      0x2e, 0x30, 0x2e, 0x30,
+      0xda, 0x00, 0x01, 0x03, 0x00, 0x81, 0x68, 0x74,
+      0x68, 0x69, 0x6e, 0x67, 0x5f, 0x69, 0x64
+    };
+
+    THEN("The messages are concatenated and the one not fitting the buffer is rejected") {
+      REQUIRE(first_err == Encoder::Status::Complete);
+      REQUIRE(second_err == Encoder::Status::Complete);
+      REQUIRE((first_encoded + second_encoded) == sizeof(expected_result));
+      REQUIRE(memcmp(buffer, expected_result, sizeof(expected_result)) == 0);
+      REQUIRE(third_err == Encoder::Status::Error);
+    }
+  }
+
+  /****************************************************************************/
+
   WHEN("Encode a message with unknown command Id")
   {
     OtaUpdateCmdDown command;
@@ -0,0 +1,160 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are encoded as compact records", "[ArduinoCloudThing::compactRecords]")
+{
+  /************************************************************************************/
+
+  WHEN("A 'bool' property is encoded as compact record")
+  {
+    PropertyContainer property_container;
+    CloudBool bool_test = true;
+    addPropertyToContainer(property_container, bool_test, "test", Permission::ReadWrite);
+
+    /* [["test", true]] = 9F 82 64 74 65 73 74 F5 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0x82, 0x64, 0x74, 0x65, 0x73, 0x74, 0xF5, 0xFF};
+    REQUIRE(cbor::encode(property_container, false, true) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'String' property is encoded as compact record - light payload")
+  {
+    PropertyContainer property_container;
+    CloudString str_test;
+    str_test = "ok";
+    addPropertyToContainer(property_container, str_test, "test", Permission::ReadWrite, 1);
+
+    /* [[1, "ok"]] = 9F 82 01 62 6F 6B FF */
+    std::vector<uint8_t> const expected = {0x9F, 0x82, 0x01, 0x62, 0x6F, 0x6B, 0xFF};
+    REQUIRE(cbor::encode(property_container, true, true) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A property with timestamp is encoded as compact record - light payload")
+  {
+    PropertyContainer property_container;
+    CloudInt int_test = 7;
+    addPropertyToContainer(property_container, int_test, "test", Permission::ReadWrite, 1).encodeTimestamp();
+    int_test.setTimestamp(1000);
+
+    /* [[1, 7, 1000]] = 9F 83 01 07 19 03 E8 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0x83, 0x01, 0x07, 0x19, 0x03, 0xE8, 0xFF};
+    REQUIRE(cbor::encode(property_container, true, true) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A multi value property is encoded as compact record - light payload")
+  {
+    PropertyContainer property_container;
+    CloudLocation location_test = CloudLocation(2.0f, 3.0f);
+    addPropertyToContainer(property_container, location_test, "test", Permission::ReadWrite, 1);
+
+    /* [[257, 2.0], [513, 3.0]] = 9F 82 19 01 01 FA 40 00 00 00 82 19 02 01 FA 40 40 00 00 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0x82, 0x19, 0x01, 0x01, 0xFA, 0x40, 0x00, 0x00, 0x00, 0x82, 0x19, 0x02, 0x01, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF};
+    REQUIRE(cbor::encode(property_container, true, true) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("The same property is encoded alternating compact records and SenML maps")
+  {
+    PropertyContainer property_container;
+    CloudInt int_test = 1;
+    addPropertyToContainer(property_container, int_test, "test", Permission::ReadWrite).publishEvery(0);
+
+    THEN("Each message uses the requested record format")
+    {
+      /* [["test", 1]] = 9F 82 64 74 65 73 74 01 FF */
+      std::vector<uint8_t> const expected_compact = {0x9F, 0x82, 0x64, 0x74, 0x65, 0x73, 0x74, 0x01, 0xFF};
+      /* [{0: "test", 2: 1}] = 9F A2 00 64 74 65 73 74 02 01 FF */
+      std::vector<uint8_t> const expected_map = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x01, 0xFF};
+
+      REQUIRE(cbor::encode(property_container, false, true) == expected_compact);
+      REQUIRE(cbor::encode(property_container, false, false) == expected_map);
+      REQUIRE(cbor::encode(property_container, false, true) == expected_compact);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Compact records are encoded and then decoded by the peer")
+  {
+    PropertyContainer device_container, cloud_container;
+
+    CloudBool device_bool = true;
+    CloudInt device_int = -5;
+    CloudFloat device_float = 1.5f;
+    CloudString device_str;
+    device_str = "hello";
+    CloudLocation device_location = CloudLocation(2.0f, 3.0f);
+    addPropertyToContainer(device_container, device_bool, "b", Permission::ReadWrite, 1);
+    addPropertyToContainer(device_container, device_int, "i", Permission::ReadWrite, 2);
+    addPropertyToContainer(device_container, device_float, "f", Permission::ReadWrite, 3).encodeTimestamp();
+    addPropertyToContainer(device_container, device_str, "s", Permission::ReadWrite, 4);
+    addPropertyToContainer(device_container, device_location, "l", Permission::ReadWrite, 5);
+
+    CloudBool cloud_bool = false;
+    CloudInt cloud_int = 0;
+    CloudFloat cloud_float = 0.0f;
+    CloudString cloud_str;
+    CloudLocation cloud_location = CloudLocation(0.0f, 0.0f);
+    addPropertyToContainer(cloud_container, cloud_bool, "b", Permission::ReadWrite, 1);
+    addPropertyToContainer(cloud_container, cloud_int, "i", Permission::ReadWrite, 2);
+    addPropertyToContainer(cloud_container, cloud_float, "f", Permission::ReadWrite, 3);
+    addPropertyToContainer(cloud_container, cloud_str, "s", Permission::ReadWrite, 4);
+    addPropertyToContainer(cloud_container, cloud_location, "l", Permission::ReadWrite, 5);
+
+    THEN("All the values are recovered both with names and with identifiers")
+    {
+      bool const light_payload = GENERATE(false, true);
+      std::vector<uint8_t> const payload = cbor::encode(device_container, light_payload, true);
+      REQUIRE(payload.size() > 0);
+      CBORDecoder::decode(cloud_container, payload.data(), payload.size());
+
+      REQUIRE(cloud_bool == true);
+      REQUIRE(cloud_int == -5);
+      REQUIRE(cloud_float == 1.5f);
+      REQUIRE(cloud_str == "hello");
+      REQUIRE(cloud_location.getValue().lat == 2.0f);
+      REQUIRE(cloud_location.getValue().lon == 3.0f);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Compact records are mixed with SenML maps in the same message")
+  {
+    PropertyContainer property_container;
+    CloudInt int_test = 0;
+    CloudBool bool_test = false;
+    addPropertyToContainer(property_container, int_test, "test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, bool_test, "flag", Permission::ReadWrite, 2);
+
+    /* [["test", 7, 1000, "future"], {0: 2, 4: true}] = 82 84 64 74 65 73 74 07 19 03 E8 66 66 75 74 75 72 65 A2 00 02 04 F5 */
+    uint8_t const payload[] = {0x82, 0x84, 0x64, 0x74, 0x65, 0x73, 0x74, 0x07, 0x19, 0x03, 0xE8, 0x66, 0x66, 0x75, 0x74, 0x75, 0x72, 0x65, 0xA2, 0x00, 0x02, 0x04, 0xF5};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    REQUIRE(int_test == 7);
+    REQUIRE(bool_test == true);
+  }
+
+  /************************************************************************************/
+}
@@ -516,4 +516,28 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
     REQUIRE(actual_1 == expected_1);
   }
 
+  /************************************************************************************/
+
+  WHEN("A property is encoded alternating normal and light payload and its identifier is changed")
+  {
+    PropertyContainer property_container;
+
+    CloudLocation location_test = CloudLocation(2.0f, 3.0f);
+    addPropertyToContainer(property_container, location_test, "test", Permission::ReadWrite, 1).publishEvery(0);
+
+    /* [{0: "test:lat", 2: 2},{0: "test:lon", 2: 3}] = 9F A2 00 68 74 65 73 74 3A 6C 61 74 02 FA 40 00 00 00 A2 00 68 74 65 73 74 3A 6C 6F 6E 02 FA 40 40 00 00 FF*/
+    std::vector<uint8_t> const expected = { 0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6C, 0x61, 0x74, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6C, 0x6F, 0x6E, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF };
+    /* [{0: 257, 2: 2},{0: 513, 2: 3}] = 9F A2 00 19 01 01 02 FA 40 00 00 00 A2 00 19 02 01 02 FA 40 40 00 00 FF*/
+    std::vector<uint8_t> const expected_light = { 0x9F, 0xA2, 0x00, 0x19, 0x01, 0x01, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x19, 0x02, 0x01, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF };
+    /* [{0: 258, 2: 2},{0: 514, 2: 3}] = 9F A2 00 19 01 02 02 FA 40 00 00 00 A2 00 19 02 02 02 FA 40 40 00 00 FF*/
+    std::vector<uint8_t> const expected_light_id_2 = { 0x9F, 0xA2, 0x00, 0x19, 0x01, 0x02, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x19, 0x02, 0x02, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF };
+
+    REQUIRE(cbor::encode(property_container) == expected);
+    REQUIRE(cbor::encode(property_container, true) == expected_light);
+    REQUIRE(cbor::encode(property_container) == expected);
+
+    location_test.setIdentifier(2);
+    REQUIRE(cbor::encode(property_container, true) == expected_light_id_2);
+  }
+
 }
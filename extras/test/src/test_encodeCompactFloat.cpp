@@ -0,0 +1,124 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud float properties are encoded using the smallest lossless representation", "[ArduinoCloudThing::encodeCompactFloat]")
+{
+  /************************************************************************************/
+
+  WHEN("An integral 'float' value is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = 1000.0f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: 1000}] = 9F A2 00 64 74 65 73 74 02 19 03 E8 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x19, 0x03, 0xE8, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A zero 'float' value is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = 0.0f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: 0}] = 9F A2 00 64 74 65 73 74 02 00 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x00, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A negative zero 'float' value is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = -0.0f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: -0.0}] = 9F A2 00 64 74 65 73 74 02 F9 80 00 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x80, 0x00, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'float' value which is exactly representable as half float is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = 21.5f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: 21.5}] = 9F A2 00 64 74 65 73 74 02 F9 4D 60 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x4D, 0x60, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'float' value which is exactly representable as subnormal half float is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = ldexpf(1.0f, -24);
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: 5.960464477539063e-08}] = 9F A2 00 64 74 65 73 74 02 F9 00 01 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x00, 0x01, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'float' value which is not representable as half float is encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = 0.1f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test", 2: 0.1}] = 9F A2 00 64 74 65 73 74 02 FA 3D CC CC CD FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xFA, 0x3D, 0xCC, 0xCC, 0xCD, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'float' value is quantized to the property resolution before being encoded")
+  {
+    PropertyContainer property_container;
+    CloudFloat float_test = 3.14159f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat(0.25f);
+
+    /* [{0: "test", 2: 3.25}] = 9F A2 00 64 74 65 73 74 02 F9 42 80 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x42, 0x80, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A multi value property with 'float' attributes is encoded")
+  {
+    PropertyContainer property_container;
+    CloudLocation location_test = CloudLocation(2.0f, 3.5f);
+    addPropertyToContainer(property_container, location_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    /* [{0: "test:lat", 2: 2},{0: "test:lon", 2: 3.5}] = 9F A2 00 68 74 65 73 74 3A 6C 61 74 02 02 A2 00 68 74 65 73 74 3A 6C 6F 6E 02 F9 43 00 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6C, 0x61, 0x74, 0x02, 0x02, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6C, 0x6F, 0x6E, 0x02, 0xF9, 0x43, 0x00, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+  }
+
+  /************************************************************************************/
+}
@@ -0,0 +1,82 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are packed into a size constrained frame", "[ArduinoCloudThing::encodePacked]")
+{
+  /************************************************************************************/
+
+  WHEN("A 'String' property which doesn't fit the frame precedes smaller properties")
+  {
+    PropertyContainer property_container;
+
+    CloudString str;
+    str = "hello world";
+    CloudInt a = 1;
+    CloudInt b = 2;
+    addPropertyToContainer(property_container, str, "s", Permission::ReadWrite);
+    addPropertyToContainer(property_container, a, "a", Permission::ReadWrite);
+    addPropertyToContainer(property_container, b, "b", Permission::ReadWrite);
+
+    THEN("The smaller properties are packed into the frame")
+    {
+      uint8_t buf[16] = {0};
+      int bytes_encoded = 0;
+      REQUIRE(CBOREncoder::encodePacked(property_container, buf, sizeof(buf), bytes_encoded) == CborNoError);
+
+      /* [{0: "a", 2: 1}, {0: "b", 2: 2}] = 9F A2 00 61 61 02 01 A2 00 61 62 02 02 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x61, 0x62, 0x02, 0x02, 0xFF};
+      std::vector<uint8_t> const actual(buf, buf + bytes_encoded);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("More properties are changed than a single frame can hold")
+  {
+    PropertyContainer property_container;
+
+    CloudInt a = 1;
+    CloudInt b = 2;
+    CloudInt c = 3;
+    addPropertyToContainer(property_container, a, "a", Permission::ReadWrite);
+    addPropertyToContainer(property_container, b, "b", Permission::ReadWrite);
+    addPropertyToContainer(property_container, c, "c", Permission::ReadWrite);
+
+    THEN("The property left out is sent with the next frame")
+    {
+      uint8_t buf[16] = {0};
+      int bytes_encoded = 0;
+
+      REQUIRE(CBOREncoder::encodePacked(property_container, buf, sizeof(buf), bytes_encoded) == CborNoError);
+      REQUIRE(bytes_encoded == 14);
+      REQUIRE(c.getDeferredUpdateCount() == 1);
+
+      REQUIRE(CBOREncoder::encodePacked(property_container, buf, sizeof(buf), bytes_encoded) == CborNoError);
+      /* [{0: "c", 2: 3}] = 9F A2 00 61 63 02 03 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x61, 0x63, 0x02, 0x03, 0xFF};
+      std::vector<uint8_t> const actual(buf, buf + bytes_encoded);
+      REQUIRE(actual == expected);
+      REQUIRE(c.getDeferredUpdateCount() == 0);
+
+      REQUIRE(CBOREncoder::encodePacked(property_container, buf, sizeof(buf), bytes_encoded) == CborNoError);
+      REQUIRE(bytes_encoded == 0);
+    }
+  }
+
+  /************************************************************************************/
+}
@@ -0,0 +1,125 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <CBOREncoder.h>
+#include <CBORDecoder.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties larger than the encoder buffer are streamed to a sink", "[ArduinoCloudThing::encodeToSink]")
+{
+  /************************************************************************************/
+
+  WHEN("A 'String' property larger than the chunk buffer is encoded")
+  {
+    PropertyContainer property_container;
+    CloudString str_test;
+    CloudInt int_test = 7;
+    str_test = std::string(1000, 'x');
+    addPropertyToContainer(property_container, int_test, "i", Permission::ReadWrite).encodeTimestamp();
+    addPropertyToContainer(property_container, str_test, "s", Permission::ReadWrite).encodeTimestamp();
+    int_test.setTimestamp(1000);
+    str_test.setTimestamp(1000);
+
+    THEN("The regular encoder only sends the other properties and can't fit it into the buffer")
+    {
+      uint8_t buf[64] = {0};
+      int bytes_encoded = 0;
+      unsigned int current_property_index = 1;
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded > 0);
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborErrorOutOfMemory);
+      REQUIRE(bytes_encoded == 0);
+    }
+
+    THEN("The streamed message announces its size up front and matches the one encoded into a large enough buffer")
+    {
+      bool const compact_records = GENERATE(false, true);
+
+      PropertyContainer reference_container;
+      CloudString reference_str;
+      CloudInt reference_int = 7;
+      reference_str = std::string(1000, 'x');
+      addPropertyToContainer(reference_container, reference_int, "i", Permission::ReadWrite).encodeTimestamp();
+      addPropertyToContainer(reference_container, reference_str, "s", Permission::ReadWrite).encodeTimestamp();
+      reference_int.setTimestamp(1000);
+      reference_str.setTimestamp(1000);
+
+      std::vector<uint8_t> expected(2048);
+      int expected_size = 0;
+      unsigned int current_property_index = 0;
+      REQUIRE(CBOREncoder::encode(reference_container, expected.data(), expected.size(), expected_size, current_property_index, false, compact_records) == CborNoError);
+      expected.resize(expected_size);
+
+      uint8_t chunk[64] = {0};
+      size_t announced_size = 0, bytes_encoded = 0, max_chunk_size = 0;
+      std::vector<uint8_t> actual;
+
+      REQUIRE(CBOREncoder::encodeToSink(property_container, chunk, sizeof(chunk),
+        [&announced_size](size_t const size) { announced_size = size; return true; },
+        [&actual, &max_chunk_size](uint8_t const * data, size_t const length)
+        {
+          actual.insert(actual.end(), data, data + length);
+          max_chunk_size = std::max(max_chunk_size, length);
+          return true;
+        },
+        bytes_encoded, false, compact_records) == CborNoError);
+
+      REQUIRE(actual == expected);
+      REQUIRE(announced_size == expected.size());
+      REQUIRE(bytes_encoded == expected.size());
+      /* Only the string value itself is handed over in a single chunk larger than the buffer */
+      REQUIRE(max_chunk_size == 1000);
+
+      /* Once delivered, nothing is pending anymore */
+      REQUIRE(cbor::encode(property_container).empty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The sink fails while a property is streamed")
+  {
+    PropertyContainer property_container;
+    CloudString str_test;
+    str_test = std::string(300, 'x');
+    addPropertyToContainer(property_container, str_test, "s", Permission::ReadWrite);
+
+    THEN("The property is still pending and can be streamed again")
+    {
+      uint8_t chunk[32] = {0};
+      size_t bytes_encoded = 0;
+      std::vector<uint8_t> actual;
+
+      REQUIRE(CBOREncoder::encodeToSink(property_container, chunk, sizeof(chunk),
+        [](size_t const) { return true; },
+        [](uint8_t const *, size_t const) { return false; },
+        bytes_encoded) == CborErrorIO);
+      REQUIRE(bytes_encoded == 0);
+
+      REQUIRE(CBOREncoder::encodeToSink(property_container, chunk, sizeof(chunk),
+        [](size_t const) { return true; },
+        [&actual](uint8_t const * data, size_t const length) { actual.insert(actual.end(), data, data + length); return true; },
+        bytes_encoded) == CborNoError);
+      REQUIRE(bytes_encoded == actual.size());
+
+      PropertyContainer cloud_container;
+      CloudString cloud_str;
+      addPropertyToContainer(cloud_container, cloud_str, "s", Permission::ReadWrite);
+      CBORDecoder::decode(cloud_container, actual.data(), actual.size());
+      REQUIRE(cloud_str == std::string(300, 'x'));
+    }
+  }
+
+  /************************************************************************************/
+}
@@ -0,0 +1,126 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are encoded by priority", "[ArduinoCloudThing::priority]")
+{
+  /************************************************************************************/
+
+  WHEN("A 'High' priority property is added after a 'Normal' priority property")
+  {
+    PropertyContainer property_container;
+
+    CloudInt normal = 1;
+    CloudInt high = 2;
+    addPropertyToContainer(property_container, normal, "n", Permission::ReadWrite);
+    addPropertyToContainer(property_container, high, "h", Permission::ReadWrite).priority(Priority::High);
+
+    THEN("The 'High' priority property is encoded first")
+    {
+      /* [{0: "h", 2: 2}, {0: "n", 2: 1}] = 9F A2 00 61 68 02 02 A2 00 61 6E 02 01 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x61, 0x68, 0x02, 0x02, 0xA2, 0x00, 0x61, 0x6E, 0x02, 0x01, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A 'Low' priority property competes with an always pending 'High' priority property for a single record message")
+  {
+    PropertyContainer property_container;
+    set_millis(0);
+
+    CloudInt high = 1;
+    CloudInt low = 2;
+    addPropertyToContainer(property_container, high, "h", Permission::ReadWrite).publishEvery(0).priority(Priority::High);
+    addPropertyToContainer(property_container, low, "l", Permission::ReadWrite).priority(Priority::Low);
+
+    THEN("The 'Low' priority property is not starved")
+    {
+      /* [{0: "l", 2: 2}] = 9F A2 00 61 6C 02 02 FF */
+      std::vector<uint8_t> const expected_low = {0x9F, 0xA2, 0x00, 0x61, 0x6C, 0x02, 0x02, 0xFF};
+      unsigned int current_property_index = 0;
+      bool low_encoded = false;
+
+      for (unsigned int i = 0; (i < 3 * Property::PRIORITY_AGING_DEFERRED_UPDATES) && !low_encoded; i++)
+      {
+        uint8_t buf[10] = {0};
+        int bytes_encoded = 0;
+        REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+        REQUIRE(bytes_encoded == 8);
+        low_encoded = (std::vector<uint8_t>(buf, buf + bytes_encoded) == expected_low);
+      }
+
+      REQUIRE(low_encoded);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A property too large for the message competes with always pending properties")
+  {
+    PropertyContainer property_container;
+    set_millis(0);
+
+    CloudString large;
+    large = "This string never fits into the message buffer.";
+    CloudInt a = 1;
+    CloudInt b = 2;
+    Property & large_property = addPropertyToContainer(property_container, large, "s", Permission::ReadWrite);
+    addPropertyToContainer(property_container, a, "a", Permission::ReadWrite).publishEvery(0);
+    addPropertyToContainer(property_container, b, "b", Permission::ReadWrite).publishEvery(0);
+
+    THEN("The large property is neither aged nor promoted and the other ones are still sent")
+    {
+      /* [{0: "a", 2: 1}, {0: "b", 2: 2}] = 9F A2 00 61 61 02 01 A2 00 61 62 02 02 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x61, 0x62, 0x02, 0x02, 0xFF};
+      unsigned int current_property_index = 0;
+
+      for (unsigned int i = 0; i < 3 * Property::PRIORITY_AGING_DEFERRED_UPDATES; i++)
+      {
+        uint8_t buf[20] = {0};
+        int bytes_encoded = 0;
+        REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+        REQUIRE(std::vector<uint8_t>(buf, buf + bytes_encoded) == expected);
+        REQUIRE(large_property.getDeferredUpdateCount() == 0);
+        REQUIRE(large_property.schedulingPriority() == Priority::Normal);
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Only a property too large for the message is pending")
+  {
+    PropertyContainer property_container;
+
+    CloudString large;
+    large = "This string never fits into the message buffer.";
+    addPropertyToContainer(property_container, large, "s", Permission::ReadWrite);
+
+    THEN("Nothing is encoded and the property is reported as not fitting")
+    {
+      uint8_t buf[20] = {0};
+      int bytes_encoded = 0;
+      unsigned int current_property_index = 0;
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborErrorOutOfMemory);
+      REQUIRE(bytes_encoded == 0);
+    }
+  }
+
+  /************************************************************************************/
+}
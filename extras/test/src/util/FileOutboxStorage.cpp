@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <util/FileOutboxStorage.h>
+
+#include <algorithm>
+
+/**************************************************************************************
+   CTOR/DTOR
+ **************************************************************************************/
+
+FileOutboxStorage::FileOutboxStorage(std::string const & path, size_t const sector_size, size_t const sector_count)
+: _file{nullptr}
+, _sector_size{sector_size}
+, _sector_count{sector_count}
+, _erase_count(sector_count, 0)
+, _write_budget{0}
+, _write_limited{false}
+{
+  /* Reuse the content of an existing file, a new one is created fully erased */
+  _file = std::fopen(path.c_str(), "r+b");
+  if (_file == nullptr)
+  {
+    _file = std::fopen(path.c_str(), "w+b");
+    std::vector<uint8_t> const erased(_sector_size * _sector_count, 0xFF);
+    if (_file != nullptr)
+      std::fwrite(erased.data(), 1, erased.size(), _file);
+  }
+}
+
+FileOutboxStorage::~FileOutboxStorage()
+{
+  if (_file != nullptr)
+    std::fclose(_file);
+}
+
+/**************************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+bool FileOutboxStorage::read(size_t const address, uint8_t * data, size_t const len)
+{
+  if ((_file == nullptr) || ((address + len) > (_sector_size * _sector_count)))
+    return false;
+  if (std::fseek(_file, static_cast<long>(address), SEEK_SET) != 0)
+    return false;
+  return std::fread(data, 1, len, _file) == len;
+}
+
+bool FileOutboxStorage::write(size_t const address, uint8_t const * data, size_t const len)
+{
+  std::vector<uint8_t> programmed(len);
+  if (!read(address, programmed.data(), len))
+    return false;
+
+  size_t const count = _write_limited ? std::min(len, _write_budget) : len;
+  if (_write_limited)
+    _write_budget -= count;
+
+  /* Programming can only clear bits */
+  for (size_t i = 0; i < count; i++)
+    programmed[i] &= data[i];
+
+  if (std::fseek(_file, static_cast<long>(address), SEEK_SET) != 0)
+    return false;
+  if (std::fwrite(programmed.data(), 1, len, _file) != len)
+    return false;
+  std::fflush(_file);
+  return count == len;
+}
+
+bool FileOutboxStorage::erase(size_t const sector)
+{
+  if ((_file == nullptr) || (sector >= _sector_count))
+    return false;
+  if (_write_limited && (_write_budget == 0))
+    return false;
+
+  std::vector<uint8_t> const erased(_sector_size, 0xFF);
+  if (std::fseek(_file, static_cast<long>(sector * _sector_size), SEEK_SET) != 0)
+    return false;
+  if (std::fwrite(erased.data(), 1, erased.size(), _file) != erased.size())
+    return false;
+  std::fflush(_file);
+  _erase_count[sector]++;
+  return true;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2024 Arduino.  All rights reserved.
+ */
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <algorithm>
+
+#include <util/TLSLoopback.h>
+#include <tls/profile/aiotc_profile.h>
+
+/**************************************************************************************
+   GLOBAL VARIABLES
+ **************************************************************************************/
+
+static TLSLoopback * loopback_server = nullptr;
+static br_x509_knownkey_context loopback_known_key;
+
+/**************************************************************************************
+   CTOR/DTOR
+ **************************************************************************************/
+
+TLSLoopback::TLSLoopback(size_t const chain_size)
+: _chain_data(chain_size, 0x30)
+, _connected{false}
+, _established{false}
+, _ignore_max_fragment_length{false}
+, _handshake_count{0}
+, _record_count{0}
+, _server_time{0}
+{
+  /* Always the same server keys, the client only knows their public part */
+  br_hmac_drbg_init(&_rng, &br_sha256_vtable, "TLSLoopback", 11);
+  changeKey();
+
+  /* The client validates the server by its key, the chain content is not looked at */
+  _chain.data = _chain_data.data();
+  _chain.data_len = _chain_data.size();
+
+  br_ssl_session_cache_lru_init(&_cache, _cache_buf, sizeof(_cache_buf));
+}
+
+/**************************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void TLSLoopback::clientProfile(br_ssl_client_context * cc, br_x509_minimal_context * xc, const br_x509_trust_anchor * trust_anchors, size_t trust_anchors_num)
+{
+  aiotc_client_profile_init(cc, xc, trust_anchors, trust_anchors_num);
+  br_x509_knownkey_init_ec(&loopback_known_key, &loopback_server->_pk, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN);
+  br_ssl_engine_set_x509(&cc->eng, &loopback_known_key.vtable);
+}
+
+void TLSLoopback::changeKey()
+{
+  br_ec_keygen(&_rng.vtable, br_ec_get_default(), &_sk, _sk_buf, BR_EC_secp256r1);
+  br_ec_compute_pub(br_ec_get_default(), &_pk, _pk_buf, &_sk);
+}
+
+unsigned long TLSLoopback::getTime()
+{
+  return 1700000000UL;
+}
+
+int TLSLoopback::connect(IPAddress, uint16_t)
+{
+  return connect("loopback", 0);
+}
+
+int TLSLoopback::connect(const char *, uint16_t)
+{
+  loopback_server = this;
+
+  br_ssl_server_init_full_ec(&_sc, &_chain, 1, BR_KEYTYPE_EC, &_sk);
+  br_ssl_engine_set_buffer(&_sc.eng, _buf, sizeof(_buf), 1);
+  br_ssl_server_set_cache(&_sc, &_cache.vtable);
+  br_ssl_engine_inject_entropy(&_sc.eng, "TLSLoopback", 11);
+  if (!br_ssl_server_reset(&_sc))
+    return 0;
+
+  _rx.clear();
+  _echo.clear();
+  _connected = true;
+  _established = false;
+  return 1;
+}
+
+size_t TLSLoopback::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t TLSLoopback::write(const uint8_t * buf, size_t size)
+{
+  size_t written = 0;
+
+  while (_connected && written < size)
+  {
+    service(false);
+
+    size_t len = 0;
+    unsigned char * rec = br_ssl_engine_recvrec_buf(&_sc.eng, &len);
+    if (rec == nullptr)
+      break;
+
+    len = min(len, size - written);
+    memcpy(rec, buf + written, len);
+    br_ssl_engine_recvrec_ack(&_sc.eng, len);
+    written += len;
+  }
+
+  service(false);
+  return written;
+}
+
+int TLSLoopback::available()
+{
+  service(true);
+  return _rx.size();
+}
+
+int TLSLoopback::read()
+{
+  uint8_t b;
+  return (read(&b, 1) == 1) ? b : -1;
+}
+
+int TLSLoopback::read(uint8_t * buf, size_t size)
+{
+  service(true);
+  if (_rx.empty())
+    return -1;
+
+  size_t const len = min(size, _rx.size());
+  std::copy(_rx.begin(), _rx.begin() + len, buf);
+  _rx.erase(_rx.begin(), _rx.begin() + len);
+  return len;
+}
+
+int TLSLoopback::peek()
+{
+  return _rx.empty() ? -1 : _rx.front();
+}
+
+void TLSLoopback::flush()
+{
+
+}
+
+void TLSLoopback::stop()
+{
+  _connected = false;
+}
+
+uint8_t TLSLoopback::connected()
+{
+  if (!_connected)
+    return 0;
+
+  return !_rx.empty() || !(br_ssl_engine_current_state(&_sc.eng) & BR_SSL_CLOSED);
+}
+
+TLSLoopback::operator bool()
+{
+  return _connected;
+}
+
+/**************************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void TLSLoopback::service(bool const echo)
+{
+  auto const start = std::chrono::steady_clock::now();
+  serviceEngine(echo);
+  _server_time += std::chrono::steady_clock::now() - start;
+}
+
+void TLSLoopback::serviceEngine(bool const echo)
+{
+  for (;;)
+  {
+    unsigned const state = br_ssl_engine_current_state(&_sc.eng);
+    size_t len = 0;
+
+    if (state & BR_SSL_CLOSED)
+      return;
+
+    if (state & BR_SSL_SENDREC) {
+      unsigned char * rec = br_ssl_engine_sendrec_buf(&_sc.eng, &len);
+      _rx.insert(_rx.end(), rec, rec + len);
+      br_ssl_engine_sendrec_ack(&_sc.eng, len);
+      continue;
+    }
+
+    if (state & BR_SSL_RECVAPP) {
+      unsigned char * app = br_ssl_engine_recvapp_buf(&_sc.eng, &len);
+      _echo.insert(_echo.end(), app, app + len);
+      _record_count++;
+      br_ssl_engine_recvapp_ack(&_sc.eng, len);
+      continue;
+    }
+
+    if ((state & BR_SSL_SENDAPP) && !_established) {
+      _established = true;
+      _handshake_count++;
+      if (_ignore_max_fragment_length) {
+        /* The next records are prepared with the new length, start one with an empty record */
+        _sc.eng.max_frag_len = 16384;
+        br_ssl_engine_flush(&_sc.eng, 1);
+      }
+      continue;
+    }
+
+    if ((state & BR_SSL_SENDAPP) && echo && !_echo.empty()) {
+      unsigned char * app = br_ssl_engine_sendapp_buf(&_sc.eng, &len);
+      len = min(len, _echo.size());
+      memcpy(app, _echo.data(), len);
+      _echo.erase(_echo.begin(), _echo.begin() + len);
+      br_ssl_engine_sendapp_ack(&_sc.eng, len);
+      br_ssl_engine_flush(&_sc.eng, 0);
+      continue;
+    }
+
+    return;
+  }
+}
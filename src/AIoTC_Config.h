@@ -178,6 +178,18 @@
   #define AIOT_CONFIG_LASTVALUES_SYNC_MAX_RETRY_CNT                  (10UL)
 #endif
 
+#if defined(HAS_TCP)
+  #define AIOT_CONFIG_OUTBOX_SIZE                                   (1024UL)
+  #define AIOT_CONFIG_OUTBOX_BURST_SIZE                                (4UL)
+  #define AIOT_CONFIG_OUTBOX_MAX_BYTES_PER_SECOND                   (2048UL)
+  #define AIOT_CONFIG_MQTT_INFLIGHT_WINDOW_SIZE                        (4UL)
+  #define AIOT_CONFIG_TLS_HANDSHAKE_TIMEOUT_ms                     (30000UL)
+  #define AIOT_CONFIG_FAST_RECONNECT_WINDOW_ms                     (60000UL)
+  #define AIOT_CONFIG_TIME_SYNC_MAX_AGE_ms                       (3600000UL)
+  #define AIOT_CONFIG_MQTT_INBOUND_BUDGET_ms                          (50UL)
+  #define AIOT_CONFIG_TLS_KEY_SHARE_IDLE_ms                           (10UL)
+#endif
+
 #define AIOT_CONFIG_LIB_VERSION "2.1.0"
 
 #endif /* ARDUINO_AIOTC_CONFIG_H_ */
@@ -42,6 +42,9 @@ public:
   inline bool isAttached() {
     return _attached;
   };
+  inline void setBackoffPolicy(TimedAttempt::BackoffPolicy policy, uint32_t seed) {
+    _attachAttempt.setBackoffPolicy(policy, seed);
+  }
 
 
 private:
@@ -51,6 +51,8 @@ ArduinoIoTCloudLPWAN::ArduinoIoTCloudLPWAN()
 , _retryEnable{false}
 , _maxNumRetry{5}
 , _intervalRetry{AIOT_CONFIG_LPWAN_UPDATE_RETRY_DELAY_ms}
+, _packingEnable{false}
+, _compactRecordsEnable{false}
 , _thing_property_container()
 , _last_checked_property_index{0}
 {
@@ -151,7 +153,14 @@ void ArduinoIoTCloudLPWAN::sendPropertiesToCloud()
   int bytes_encoded = 0;
   uint8_t data[CBOR_LORA_MSG_MAX_SIZE];
 
-  if (CBOREncoder::encode(_thing_property_container, data, sizeof(data), bytes_encoded, _last_checked_property_index, true) == CborNoError)
+  CborError error = CborNoError;
+
+  if (_packingEnable)
+    error = CBOREncoder::encodePacked(_thing_property_container, data, sizeof(data), bytes_encoded, true, _compactRecordsEnable);
+  else
+    error = CBOREncoder::encode(_thing_property_container, data, sizeof(data), bytes_encoded, _last_checked_property_index, true, _compactRecordsEnable);
+
+  if (error == CborNoError)
     if (bytes_encoded > 0)
       writeProperties(data, bytes_encoded);
 }
@@ -44,10 +44,16 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
     inline bool isRetryEnabled  () const { return _retryEnable; }
     inline int  getMaxRetry     () const { return _maxNumRetry; }
     inline long getIntervalRetry() const { return _intervalRetry; }
+    inline bool isPackingEnabled() const { return _packingEnable; }
+    inline bool isCompactRecordsEnabled() const { return _compactRecordsEnable; }
 
     inline void enableRetry     (bool val) { _retryEnable = val; }
     inline void setMaxRetry     (int val)  { _maxNumRetry = val; }
     inline void setIntervalRetry(long val) { _intervalRetry = val; }
+    /* When enabled each uplink carries the subset of changed properties which best fills the frame instead of stopping at the first one which doesn't fit */
+    inline void enablePacking   (bool val) { _packingEnable = val; }
+    /* When enabled properties are sent as positional [id, value] records instead of SenML maps, the network server decoder must support them */
+    inline void enableCompactRecords(bool val) { _compactRecordsEnable = val; }
 
     inline PropertyContainer &getThingPropertyContainer() { return _thing_property_container; }
 
@@ -65,6 +71,8 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
     bool _retryEnable;
     int _maxNumRetry;
     long _intervalRetry;
+    bool _packingEnable;
+    bool _compactRecordsEnable;
 
     PropertyContainer _thing_property_container;
     unsigned int _last_checked_property_index;
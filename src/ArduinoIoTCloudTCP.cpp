@@ -50,12 +50,31 @@ unsigned long getTime()
 ArduinoIoTCloudTCP::ArduinoIoTCloudTCP()
 : _state{State::ConnectPhy}
 , _connection_attempt(0,0)
+#if defined(BOARD_HAS_ECCX08)
+, _handshake_start_ms{0}
+, _tlsKeySharePrecomputationEnable{false}
+#endif
+, _disconnect_tick{0}
+, _fast_reconnect_thing_id("")
+, _fast_reconnect_thing_synced{false}
 , _message_stream(std::bind(&ArduinoIoTCloudTCP::sendMessage, this, std::placeholders::_1))
 , _thing(&_message_stream)
 , _device(&_message_stream)
 , _mqtt_data_buf{0}
 , _mqtt_data_len{0}
 , _mqtt_data_request_retransmit{false}
+, _compactRecordsEnable{false}
+, _outboxEnable{false}
+, _outbox(AIOT_CONFIG_OUTBOX_SIZE, MQTT_TRANSMIT_BUFFER_SIZE)
+, _persistentOutbox(MQTT_TRANSMIT_BUFFER_SIZE)
+, _activeOutbox{&_outbox}
+, _qos1Enable{false}
+, _commandBatchingEnable{false}
+, _mqttPersistentSessionEnable{false}
+, _sessionDataTopicIn("")
+, _mqtt_cmd_len{0}
+, _backoff_policy{TimedAttempt::exponentialBackoff}
+, _inflight(AIOT_CONFIG_MQTT_INFLIGHT_WINDOW_SIZE, MQTT_TRANSMIT_BUFFER_SIZE)
 #ifdef BOARD_HAS_SECRET_KEY
 , _password("")
 #endif
@@ -65,6 +84,9 @@ ArduinoIoTCloudTCP::ArduinoIoTCloudTCP()
 , _dataTopicOut("")
 , _dataTopicIn("")
 #if OTA_ENABLED
+#if defined(BOARD_HAS_ECCX08)
+, _tlsBufferPool(BEAR_SSL_CLIENT_IBUF_SIZE, BEAR_SSL_CLIENT_OBUF_SIZE)
+#endif
 , _ota(&_message_stream)
 , _get_ota_confirmation{nullptr}
 #endif /* OTA_ENABLED */
@@ -92,6 +114,9 @@ int ArduinoIoTCloudTCP::begin(ConnectionHandler & connection, bool const enable_
 #if  OTA_ENABLED
   /* Setup OTA TLS client */
   _otaClient.begin(connection);
+#if defined(BOARD_HAS_ECCX08)
+  _otaClient.setBufferPool(_tlsBufferPool);
+#endif
 #endif
 
   /* Setup TimeService */
@@ -146,7 +171,10 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
   }
 #endif
 
-  _mqttClient.setClient(_brokerClient);
+  /* The MQTT client is not aware of the acknowledged packets, look at them on their way */
+  _mqttAckClient.setClient(_brokerClient);
+  _mqttAckClient.onPubAck([this](uint16_t const packet_id) { _inflight.acknowledge(packet_id); });
+  _mqttClient.setClient(_mqttAckClient);
 
 #ifdef BOARD_HAS_SECRET_KEY
   if(_password.length())
@@ -159,10 +187,20 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
   _mqttClient.setKeepAliveInterval(30 * 1000);
   _mqttClient.setConnectionTimeout(1500);
   _mqttClient.setId(getDeviceId().c_str());
+  _mqttClient.setCleanSession(!_mqttPersistentSessionEnable);
 
   _messageTopicOut = getTopic_messageout();
   _messageTopicIn  = getTopic_messagein();
 
+  /* Seed the retry jitter with the device id, devices sharing a policy must not share a sequence */
+  uint32_t seed = millis();
+  for (char const * c = getDeviceId().c_str(); *c; c++) {
+    seed = seed * 31 + *c;
+  }
+  _connection_attempt.setBackoffPolicy(_backoff_policy, seed);
+  _device.setBackoffPolicy(_backoff_policy, seed + 1);
+  _thing.setBackoffPolicy(_backoff_policy, seed + 2);
+
   _thing.begin();
   _device.begin();
 
@@ -225,6 +263,16 @@ void ArduinoIoTCloudTCP::update()
   }
   _state = next_state;
 
+  /* While the connection is down record the property changes into the outbox.
+   * A thing data topic is available only if the thing has been attached before.
+   */
+  if (_outboxEnable && (_state != State::Connected) && (_dataTopicOut.length() > 0))
+  {
+    unsigned long const time = _time_service.getTime();
+    if (TimeServiceClass::isTimeValid(time))
+      _activeOutbox->record(_thing.getPropertyContainer(), time, false, _compactRecordsEnable);
+  }
+
   /* This watchdog feed is actually needed only by the RP2040 Connect because its
    * maximum watchdog window is 8389 ms; despite this we feed it for all
    * supported ARCH to keep code aligned.
@@ -246,6 +294,21 @@ void ArduinoIoTCloudTCP::printDebugInfo()
   DEBUG_INFO("MQTT Broker: %s:%d", _brokerAddress.c_str(), _brokerPort);
 }
 
+bool ArduinoIoTCloudTCP::setOutboxStorage(OutboxStorage & storage)
+{
+  if (!_persistentOutbox.begin(storage))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s outbox storage not usable", __FUNCTION__);
+    return false;
+  }
+
+  DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s %d property updates recovered", __FUNCTION__, _persistentOutbox.count());
+  _persistentOutbox.setBandwidthLimit(AIOT_CONFIG_OUTBOX_MAX_BYTES_PER_SECOND);
+  _activeOutbox = &_persistentOutbox;
+  _outboxEnable = true;
+  return true;
+}
+
 /******************************************************************************
  * PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
@@ -263,6 +326,14 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectPhy()
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SyncTime()
 {
+  /* After a short disconnection the RTC is still accurate, skip the network time query unless
+   * the last broker connection attempt failed, which may be caused by a wrong time.
+   */
+  if (!_connection_attempt.isRetry() && _time_service.isSynced(AIOT_CONFIG_TIME_SYNC_MAX_AGE_ms))
+  {
+    return State::ConnectMqttBroker;
+  }
+
   /* If available force network time sync when connecting or reconnecting */
   if (_time_service.sync())
   {
@@ -276,10 +347,77 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SyncTime()
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectMqttBroker()
 {
-  if (_mqttClient.connect(_brokerAddress.c_str(), _brokerPort))
+  bool connected = false;
+
+#if defined(BOARD_HAS_ECCX08)
+  /* Advance the TLS handshake on each call without blocking, the MQTT client adopts the connection once established */
+  switch (_brokerClient.poll())
+  {
+    case BearSSLClient::HandshakeStatus::Idle:
+      if (_brokerClient.connectAsync(_brokerAddress.c_str(), _brokerPort)) {
+        _handshake_start_ms = millis();
+        return State::ConnectMqttBroker;
+      }
+      break;
+
+    case BearSSLClient::HandshakeStatus::InProgress:
+      if ((millis() - _handshake_start_ms) < AIOT_CONFIG_TLS_HANDSHAKE_TIMEOUT_ms) {
+        return State::ConnectMqttBroker;
+      }
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s TLS handshake timeout", __FUNCTION__);
+      _brokerClient.stop();
+      break;
+
+    case BearSSLClient::HandshakeStatus::Established:
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+    {
+      BearSSLClient::HandshakeProfile const & profile = _brokerClient.getHandshakeProfile();
+      DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s TLS handshake %lu us: tcp %lu, client hello %lu (%u B), server hello %lu (%u B), client finished %lu (%u B), server finished %lu (%u B)",
+                    __FUNCTION__, profile.total, profile.tcpConnect, profile.clientHello, profile.clientHelloBytes,
+                    profile.serverHello, profile.serverHelloBytes, profile.clientFinished, profile.clientFinishedBytes,
+                    profile.serverFinished, profile.serverFinishedBytes);
+      DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s TLS handshake certificate validation %lu us, key exchange %lu us, sign %lu us",
+                    __FUNCTION__, profile.certValidation, profile.keyExchange, profile.sign);
+    }
+#endif
+      connected = _mqttClient.connect(_brokerAddress.c_str(), _brokerPort);
+      break;
+
+    case BearSSLClient::HandshakeStatus::Failed:
+      break;
+  }
+#else
+  connected = _mqttClient.connect(_brokerAddress.c_str(), _brokerPort);
+#endif
+
+  if (connected)
   {
-    /* Subscribe to message topic to receive commands */
-    _mqttClient.subscribe(_messageTopicIn);
+    /* A present session still has the subscriptions of the previous connection */
+    bool const session_present = _mqttPersistentSessionEnable && _mqttAckClient.isSessionPresent();
+
+    if (session_present) {
+      DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s session present", __FUNCTION__);
+    } else {
+      _sessionDataTopicIn = "";
+      /* Subscribe to message topic to receive commands */
+      _mqttClient.subscribe(_messageTopicIn, getSubscribeQoS());
+    }
+
+    /* After a short disconnection attach the same thing again right away, skipping the device and
+     * thing configuration requests. Last values are still requested by the thing unless the session
+     * is present: with clean sessions the writes sent by the cloud while disconnected are lost.
+     */
+    if ((_fast_reconnect_thing_id.length() > 0) && ((millis() - _disconnect_tick) < AIOT_CONFIG_FAST_RECONNECT_WINDOW_ms))
+    {
+      DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s fast reconnection", __FUNCTION__);
+      String const session_data_topic_in = _sessionDataTopicIn;
+      attachThing(_fast_reconnect_thing_id);
+      /* The writes missed by a synced thing are queued in the session */
+      if (_fast_reconnect_thing_synced && (session_data_topic_in == _dataTopicIn)) {
+        _thing.resume();
+      }
+    }
+    _fast_reconnect_thing_id = "";
 
     DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s connected to %s:%d", __FUNCTION__, _brokerAddress.c_str(), _brokerPort);
     return State::Connected;
@@ -301,8 +439,22 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
     return State::Disconnect;
   }
 
-  /* Check for new data from the MQTT client. */
-  _mqttClient.poll();
+  /* Check for new data from the MQTT client. Keep dispatching the inbound messages
+   * until the socket is empty or the time budget is spent, so that a burst of
+   * writes from the cloud is not processed at one message per update.
+   */
+  unsigned long const inbound_start = millis();
+  do {
+    _mqttClient.poll();
+  } while (_mqttClient.connected() && (_mqttAckClient.available() > 0) &&
+           ((millis() - inbound_start) < AIOT_CONFIG_MQTT_INBOUND_BUDGET_ms));
+
+#if defined(BOARD_HAS_ECCX08)
+  /* The MQTT client writes each packet in several pieces: send the packets
+   * published during this update in as few TLS records as possible.
+   */
+  _brokerClient.cork();
+#endif
 
   /* Retransmit data in case there was a lost transaction due
    * to phy layer or MQTT connectivity loss.
@@ -331,6 +483,19 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
     _thing.update();
   }
 
+  /* Publish the commands queued during this update at once */
+  sendCommandsToCloud();
+
+#if defined(BOARD_HAS_ECCX08)
+  _brokerClient.uncork();
+
+  /* Take the key share of the next handshake out of the reconnection, in an update with time to spare */
+  if (_tlsKeySharePrecomputationEnable && !BearSSLClient::hasKeyShare() &&
+      ((millis() - inbound_start) < AIOT_CONFIG_TLS_KEY_SHARE_IDLE_ms)) {
+    BearSSLClient::precomputeKeyShare();
+  }
+#endif
+
   return State::Connected;
 }
 
@@ -339,10 +504,21 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Disconnect()
   if (!_mqttClient.connected()) {
     DEBUG_ERROR("ArduinoIoTCloudTCP::%s MQTT client connection lost", __FUNCTION__);
   } else {
-    /* No need to manually unsubscribe because we are using clean sessions */
+    /* No need to manually unsubscribe: clean sessions drop the subscriptions, persistent ones keep them */
     _mqttClient.stop();
   }
 
+  /* The packet identifiers of the unacknowledged messages are not valid for the next session */
+  _inflight.expire();
+
+  /* Commands queued for the lost connection will be generated again */
+  _mqtt_cmd_len = 0;
+
+  /* Remember the attached thing, to attach it again without asking the cloud if reconnecting shortly */
+  _fast_reconnect_thing_id = _device.isAttached() ? _thing_id : String("");
+  _fast_reconnect_thing_synced = _thing.isSynced();
+  _disconnect_tick = millis();
+
   Message message = { ResetCmdId };
   _thing.handleMessage(&message);
   _device.handleMessage(&message);
@@ -364,10 +540,30 @@ void ArduinoIoTCloudTCP::handleMessage(int length)
 {
   String topic = _mqttClient.messageTopic();
 
-  byte bytes[length];
+  /* The size of the message is chosen by the peer, don't let it decide the heap taken */
+  if (length > MQTT_RECEIVE_BUFFER_SIZE) {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s dropping %d bytes message, larger than %d bytes", __FUNCTION__, length, MQTT_RECEIVE_BUFFER_SIZE);
+    discardMessage(length);
+    return;
+  }
 
-  for (int i = 0; i < length; i++) {
-    bytes[i] = _mqttClient.read();
+  /* Read the payload at once into a receive buffer kept across messages, it only grows
+   * to the size of the largest message received instead of taking it from the stack.
+   */
+  if (_mqtt_rx_buf.size() < static_cast<size_t>(length)) {
+    _mqtt_rx_buf.resize(length);
+  }
+  uint8_t * bytes = _mqtt_rx_buf.data();
+
+  int received = 0;
+  while (received < length) {
+    int const result = _mqttClient.read(bytes + received, length - received);
+    if (result <= 0) {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not read %d bytes message", __FUNCTION__, length);
+      discardMessage(length - received);
+      return;
+    }
+    received += result;
   }
 
   /* Topic for user input data */
@@ -459,14 +655,40 @@ void ArduinoIoTCloudTCP::handleMessage(int length)
   }
 }
 
+void ArduinoIoTCloudTCP::discardMessage(int length)
+{
+  uint8_t chunk[32];
+  while (length > 0) {
+    size_t const chunk_length = (length < static_cast<int>(sizeof(chunk))) ? static_cast<size_t>(length) : sizeof(chunk);
+    int const result = _mqttClient.read(chunk, chunk_length);
+    if (result <= 0) {
+      /* The rest of the packet can't be skipped, the stream is no longer in sync: start over */
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not discard %d bytes, disconnecting", __FUNCTION__, length);
+      _mqttClient.stop();
+      return;
+    }
+    length -= result;
+  }
+}
+
 void ArduinoIoTCloudTCP::sendMessage(Message * msg)
 {
-  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
-  size_t bytes_encoded = sizeof(data);
+  size_t bytes_encoded = sizeof(_mqtt_data_buf);
   CBORMessageEncoder encoder;
 
   switch (msg->id) {
     case PropertiesUpdateCmdId:
+      /* Properties are encoded into the TX buffer, publish the queued commands first */
+      sendCommandsToCloud();
+      /* Deliver the unacknowledged updates and the ones recorded while offline before any newer one */
+      if (_inflight.hasExpired())
+        return resendInflightToCloud();
+      /* Properties are committed once encoded, wait for a free slot before encoding them */
+      if (_qos1Enable && _inflight.isFull())
+        return;
+      /* An outbox held back by its bandwidth limit or by unreadable entries doesn't stop the live updates */
+      if (!_activeOutbox->isEmpty() && sendOutboxToCloud())
+        return;
       return sendPropertyContainerToCloud(_dataTopicOut,
                                           _thing.getPropertyContainer(),
                                           _thing.getPropertyContainerIndex());
@@ -476,9 +698,31 @@ void ArduinoIoTCloudTCP::sendMessage(Message * msg)
       break;
   }
 
-  if (encoder.encode(msg, data, bytes_encoded) == Encoder::Status::Complete &&
+  /* Command messages are encoded in place into the TX buffer as well,
+   * overwriting the properties payload kept for retransmission.
+   */
+  _mqtt_data_len = 0;
+  _mqtt_data_request_retransmit = false;
+
+  if (_commandBatchingEnable) {
+    /* Append the command to the ones already queued, a CBOR sequence is the concatenation of its items */
+    bytes_encoded = sizeof(_mqtt_data_buf) - _mqtt_cmd_len;
+    if (encoder.encode(msg, _mqtt_data_buf + _mqtt_cmd_len, bytes_encoded) != Encoder::Status::Complete) {
+      /* Not enough room left: publish the queued commands and start a new sequence */
+      sendCommandsToCloud();
+      bytes_encoded = sizeof(_mqtt_data_buf);
+      if (encoder.encode(msg, _mqtt_data_buf, bytes_encoded) != Encoder::Status::Complete) {
+        DEBUG_ERROR("error encoding %d", msg->id);
+        return;
+      }
+    }
+    _mqtt_cmd_len += bytes_encoded;
+    return;
+  }
+
+  if (encoder.encode(msg, _mqtt_data_buf, bytes_encoded) == Encoder::Status::Complete &&
       bytes_encoded > 0) {
-    write(_messageTopicOut, data, bytes_encoded);
+    write(_messageTopicOut, _mqtt_data_buf, bytes_encoded);
   } else {
     DEBUG_ERROR("error encoding %d", msg->id);
   }
@@ -487,21 +731,100 @@ void ArduinoIoTCloudTCP::sendMessage(Message * msg)
 void ArduinoIoTCloudTCP::sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index)
 {
   int bytes_encoded = 0;
-  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
 
-  if (CBOREncoder::encode(property_container, data, sizeof(data), bytes_encoded, current_property_index, false) == CborNoError)
+  /* Properties are encoded in place into the TX buffer, which is both the
+   * source of the MQTT write and the back-up copy used for retransmission
+   * in case of failure. Whatever it held before is no longer valid.
+   */
+  _mqtt_data_len = 0;
+
+  if (CBOREncoder::encode(property_container, _mqtt_data_buf, sizeof(_mqtt_data_buf), bytes_encoded, current_property_index, false, _compactRecordsEnable) == CborNoError)
   {
     if (bytes_encoded > 0)
     {
-      /* If properties have been encoded store them in the back-up buffer
-       * in order to allow retransmission in case of failure.
-       */
       _mqtt_data_len = bytes_encoded;
-      memcpy(_mqtt_data_buf, data, _mqtt_data_len);
       /* Transmit the properties to the MQTT broker */
-      write(topic, _mqtt_data_buf, _mqtt_data_len);
+      writeData(topic, _mqtt_data_buf, _mqtt_data_len);
     }
   }
+  else
+  {
+    /* A property doesn't fit into the TX buffer: stream the changed properties
+     * to the MQTT client using the TX buffer as chunk buffer, instead of
+     * skipping it. Streamed messages are not kept for retransmission and
+     * are always published with QoS 0.
+     */
+    size_t bytes_streamed = 0;
+    bool message_started = false;
+    CborError const err = CBOREncoder::encodeToSink(property_container, _mqtt_data_buf, sizeof(_mqtt_data_buf),
+      [this, &topic, &message_started](size_t const length)
+      {
+        message_started = _mqttClient.beginMessage(topic, length, false, 0);
+        return message_started;
+      },
+      [this](uint8_t const * chunk, size_t const length)
+      {
+        return _mqttClient.write(chunk, length) == length;
+      },
+      bytes_streamed, false, _compactRecordsEnable);
+
+    if (!message_started)
+      return;
+
+    /* The announced length has not been streamed: ending the message would leave the
+     * broker reading the next packets as its payload. The connection is dropped instead
+     * and the next update goes through State::Disconnect.
+     */
+    if (err != CborNoError) {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not stream the properties, error %d", __FUNCTION__, err);
+      _mqttClient.stop();
+      return;
+    }
+
+    _mqttClient.endMessage();
+  }
+}
+
+bool ArduinoIoTCloudTCP::sendOutboxToCloud()
+{
+  /* Limit the messages sent on each update to avoid bursts after a reconnection */
+  for (unsigned int i = 0; (i < AIOT_CONFIG_OUTBOX_BURST_SIZE) && !_activeOutbox->isEmpty(); i++)
+  {
+    if (_qos1Enable && _inflight.isFull())
+      return true;
+
+    int bytes_encoded = 0;
+    _mqtt_data_len = 0;
+
+    size_t const count = _activeOutbox->encode(_mqtt_data_buf, sizeof(_mqtt_data_buf), bytes_encoded);
+    if (count == 0)
+      return i > 0;
+    if (!writeData(_dataTopicOut, _mqtt_data_buf, bytes_encoded))
+      return true;
+
+    _activeOutbox->release(count);
+  }
+  return true;
+}
+
+void ArduinoIoTCloudTCP::resendInflightToCloud()
+{
+  _inflight.resend([this](uint16_t & packet_id, uint8_t const * data, size_t const length)
+  {
+    /* The broker may have received the message already, mark it as a redelivery */
+    if (!write(_dataTopicOut, data, length, 1, true))
+      return false;
+    packet_id = _mqttAckClient.getLastPublishPacketId();
+    return true;
+  });
+}
+
+void ArduinoIoTCloudTCP::sendCommandsToCloud()
+{
+  if (_mqtt_cmd_len > 0) {
+    write(_messageTopicOut, _mqtt_data_buf, _mqtt_cmd_len);
+    _mqtt_cmd_len = 0;
+  }
 }
 
 void ArduinoIoTCloudTCP::attachThing(String thingId)
@@ -510,11 +833,16 @@ void ArduinoIoTCloudTCP::attachThing(String thingId)
 
   _dataTopicIn    = getTopic_datain();
   _dataTopicOut   = getTopic_dataout();
-  if (!_mqttClient.subscribe(_dataTopicIn)) {
-    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _dataTopicIn.c_str());
-    DEBUG_ERROR("Check your thing configuration, and press the reset button on your board.");
-    _thing_id = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
-    return;
+
+  /* The topic may still be subscribed in a present session */
+  if (_dataTopicIn != _sessionDataTopicIn) {
+    if (!_mqttClient.subscribe(_dataTopicIn, getSubscribeQoS())) {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _dataTopicIn.c_str());
+      DEBUG_ERROR("Check your thing configuration, and press the reset button on your board.");
+      _thing_id = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
+      return;
+    }
+    _sessionDataTopicIn = _dataTopicIn;
   }
 
   Message message;
@@ -532,6 +860,10 @@ void ArduinoIoTCloudTCP::detachThing()
     DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not unsubscribe from %s", __FUNCTION__, _dataTopicIn.c_str());
     return;
   }
+  _sessionDataTopicIn = "";
+
+  /* Messages for the previous thing are no longer relevant */
+  _inflight.clear();
 
   Message message;
   message = { DeviceDetachedCmdId };
@@ -542,9 +874,9 @@ void ArduinoIoTCloudTCP::detachThing()
   execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
 }
 
-int ArduinoIoTCloudTCP::write(String const topic, byte const data[], int const length)
+int ArduinoIoTCloudTCP::write(String const topic, byte const data[], int const length, int const qos, bool const dup)
 {
-  if (_mqttClient.beginMessage(topic, length, false, 0)) {
+  if (_mqttClient.beginMessage(topic, length, false, qos, dup)) {
     if (_mqttClient.write(data, length)) {
       if (_mqttClient.endMessage()) {
         return 1;
@@ -554,6 +886,17 @@ int ArduinoIoTCloudTCP::write(String const topic, byte const data[], int const l
   return 0;
 }
 
+int ArduinoIoTCloudTCP::writeData(String const topic, byte const data[], int const length)
+{
+  if (!_qos1Enable)
+    return write(topic, data, length);
+
+  /* Keep a copy of the message until the broker acknowledges it */
+  if (_inflight.isFull() || !write(topic, data, length, 1))
+    return 0;
+  return _inflight.add(_mqttAckClient.getLastPublishPacketId(), data, length) ? 1 : 0;
+}
+
 /******************************************************************************
  * EXTERN DEFINITION
  ******************************************************************************/
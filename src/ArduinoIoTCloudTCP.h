@@ -38,6 +38,7 @@
 
 #include <tls/utility/TLSClientMqtt.h>
 #include <tls/utility/TLSClientOta.h>
+#include <tls/profile/aiotc_profile.h>
 
 #if OTA_ENABLED
 #include <ota/OTA.h>
@@ -45,6 +46,10 @@
 
 #include "cbor/MessageDecoder.h"
 #include "cbor/MessageEncoder.h"
+#include "property/PropertyOutbox.h"
+#include "property/PersistentOutbox.h"
+#include "utility/mqtt/MqttAckClient.h"
+#include "utility/mqtt/MqttInflightWindow.h"
 
 /******************************************************************************
    CONSTANTS
@@ -85,6 +90,80 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     inline String   getBrokerAddress() const { return _brokerAddress; }
     inline uint16_t getBrokerPort   () const { return _brokerPort; }
 
+    inline bool isCompactRecordsEnabled() const { return _compactRecordsEnable; }
+    /* When enabled properties are sent as positional [name, value] records instead of SenML maps.
+     * Only enable it when the broker side of this connection has been configured to accept them.
+     */
+    inline void enableCompactRecords   (bool val) { _compactRecordsEnable = val; }
+
+    inline bool isOutboxEnabled() const { return _outboxEnable; }
+    /* When enabled the property changes happening while the cloud connection is down are recorded, stamped
+     * with the time of the change, and delivered once the thing is synced again. See Property::coalescing.
+     */
+    inline void enableOutbox   (bool val) { _outboxEnable = val; }
+    /* Keep the outbox into a non volatile storage instead of RAM, so that the recorded changes survive a reset.
+     * The replay is limited to AIOT_CONFIG_OUTBOX_MAX_BYTES_PER_SECOND. Enables the outbox, returns false if
+     * the storage can not be used.
+     */
+    bool setOutboxStorage(OutboxStorage & storage);
+
+    inline bool isQoS1Enabled() const { return _qos1Enable; }
+    /* When enabled property updates are published with QoS 1. Up to AIOT_CONFIG_MQTT_INFLIGHT_WINDOW_SIZE
+     * messages are kept until acknowledged by the broker, the ones not acknowledged when the connection is
+     * lost are published again once reconnected.
+     */
+    inline void enableQoS1   (bool val) { _qos1Enable = val; }
+
+    inline bool isCommandBatchingEnabled() const { return _commandBatchingEnable; }
+    /* When enabled the commands generated during an update, i.e. DeviceBegin and ThingBegin, are published
+     * together as a CBOR sequence. Only enable it when the broker side of this connection accepts them.
+     */
+    inline void enableCommandBatching   (bool val) { _commandBatchingEnable = val; }
+
+    inline bool isMqttPersistentSessionEnabled() const { return _mqttPersistentSessionEnable; }
+    /* When enabled the broker keeps the session between connections (clean session off) and the topics are
+     * subscribed with QoS 1. If the broker reports the session as present on reconnection, the subscriptions
+     * are reused and the writes sent by the cloud while disconnected are received instead of requesting the
+     * last values again. Call before begin.
+     */
+    inline void enableMqttPersistentSession   (bool val) { _mqttPersistentSessionEnable = val; }
+
+    /* Policy used to space the broker connection, thing attach and last values requests retries, i.e.
+     * TimedAttempt::fullJitterBackoff or TimedAttempt::decorrelatedJitterBackoff to keep a fleet of devices
+     * from retrying in lockstep after an outage. The jitter is seeded with the device id. Call before begin.
+     */
+    inline void setBackoffPolicy(TimedAttempt::BackoffPolicy policy) { _backoff_policy = policy; }
+
+    #if defined(BOARD_HAS_ECCX08)
+    /* The broker TLS session is resumed on reconnection. To resume it after a reset too, save the session
+     * parameters when onTlsSessionSave callback is called and pass them to setTlsSession before begin.
+     */
+    inline void setTlsSession   (br_ssl_session_parameters const & session) { _brokerClient.setSession(session); }
+    inline void onTlsSessionSave(SessionSaveCallbackFunc callback)          { _brokerClient.onSessionSave(callback); }
+    /* Negotiate a smaller TLS record size with the broker (512, 1024, 2048 or 4096 bytes) to bound the RAM
+     * touched by the broker connection, see BearSSLClient::setMaxFragmentLength. Call before begin.
+     */
+    inline void setTlsMaxFragmentLength(uint16_t const len, bool const half_duplex = false) { _brokerClient.setMaxFragmentLength(len, half_duplex); }
+    /* Authenticate the broker with its key, pinned after a full certificate chain validation, instead of validating
+     * the chain on every handshake. The chain is validated again every full_validation_interval handshakes and
+     * whenever the pinned key is refused. Call before begin.
+     */
+    inline void setTlsKeyPinning(bool const enable, unsigned int const full_validation_interval = BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL) { _brokerClient.setKeyPinning(enable, full_validation_interval); }
+    inline bool isTlsKeySharePrecomputationEnabled() const { return _tlsKeySharePrecomputationEnable; }
+    /* When enabled the ECDHE key pair of the next TLS handshake is computed while connected, in an update which
+     * took less than AIOT_CONFIG_TLS_KEY_SHARE_IDLE_ms, instead of during the reconnection.
+     */
+    inline void enableTlsKeySharePrecomputation   (bool val) { _tlsKeySharePrecomputationEnable = val; }
+    /* Select the cipher suites offered to the broker and to the OTA server, e.g. ChaCha20-Poly1305 which is
+     * faster than AES-128/GCM on boards without AES hardware, and their crypto implementations. Call before begin.
+     */
+    inline void setTlsProfile(aiotc_profile_config const & config) { aiotc_client_profile_configure(&config); }
+    #if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+    /* Phases of the last broker TLS handshake, also logged when verbose, see BearSSLClient::getHandshakeProfile */
+    inline BearSSLClient::HandshakeProfile const & getTlsHandshakeProfile() { return _brokerClient.getHandshakeProfile(); }
+    #endif
+    #endif
+
     inline PropertyContainer &getThingPropertyContainer() { return _thing.getPropertyContainer(); }
 
 #if OTA_ENABLED
@@ -105,6 +184,8 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
   private:
     static const int MQTT_TRANSMIT_BUFFER_SIZE = 256;
+    /* Largest inbound message accepted, it holds an OTA command with its URL */
+    static const int MQTT_RECEIVE_BUFFER_SIZE = 512;
 
     enum class State
     {
@@ -117,6 +198,13 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     State _state;
     TimedAttempt _connection_attempt;
+#if defined(BOARD_HAS_ECCX08)
+    unsigned long _handshake_start_ms;
+    bool _tlsKeySharePrecomputationEnable;
+#endif
+    unsigned long _disconnect_tick;
+    String _fast_reconnect_thing_id;
+    bool _fast_reconnect_thing_synced;
     MessageStream _message_stream;
     ArduinoCloudThing _thing;
     ArduinoCloudDevice _device;
@@ -124,8 +212,22 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     String _brokerAddress;
     uint16_t _brokerPort;
     uint8_t _mqtt_data_buf[MQTT_TRANSMIT_BUFFER_SIZE];
+    std::vector<uint8_t> _mqtt_rx_buf;
     int _mqtt_data_len;
     bool _mqtt_data_request_retransmit;
+    bool _compactRecordsEnable;
+    bool _outboxEnable;
+    PropertyOutbox _outbox;
+    PersistentOutbox _persistentOutbox;
+    Outbox * _activeOutbox;
+    bool _qos1Enable;
+    bool _commandBatchingEnable;
+    bool _mqttPersistentSessionEnable;
+    String _sessionDataTopicIn;
+    int _mqtt_cmd_len;
+    TimedAttempt::BackoffPolicy _backoff_policy;
+    MqttAckClient _mqttAckClient;
+    MqttInflightWindow _inflight;
 
 #if defined(BOARD_HAS_SECRET_KEY)
     String _password;
@@ -148,6 +250,10 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
 
 #if OTA_ENABLED
+  #if defined(BOARD_HAS_ECCX08)
+    /* The OTA client borrows its TLS buffers only while downloading */
+    TLSBufferPool _tlsBufferPool;
+  #endif
     TLSClientOta _otaClient;
     ArduinoCloudOTA _ota;
     onOTARequestCallbackFunc _get_ota_confirmation;
@@ -159,6 +265,9 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     inline String getTopic_dataout  () { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/e/o"); }
     inline String getTopic_datain   () { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/e/i"); }
 
+    /* A persistent session only queues the messages of QoS 1 subscriptions for later */
+    inline uint8_t getSubscribeQoS() const { return _mqttPersistentSessionEnable ? 1 : 0; }
+
     State handle_ConnectPhy();
     State handle_SyncTime();
     State handle_ConnectMqttBroker();
@@ -167,12 +276,18 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     static void onMessage(int length);
     void handleMessage(int length);
+    void discardMessage(int length);
     void sendMessage(Message * msg);
     void sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index);
+    /* Returns false if the outbox produced no message, leaving the update to the live properties */
+    bool sendOutboxToCloud();
+    void resendInflightToCloud();
+    void sendCommandsToCloud();
 
     void attachThing(String thingId);
     void detachThing();
-    int write(String const topic, byte const data[], int const length);
+    int write(String const topic, byte const data[], int const length, int const qos = 0, bool const dup = false);
+    int writeData(String const topic, byte const data[], int const length);
 
 };
 
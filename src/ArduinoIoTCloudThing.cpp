@@ -114,7 +114,8 @@ void ArduinoCloudThing::handleMessage(Message* m) {
 
 ArduinoCloudThing::State ArduinoCloudThing::handleInit() {
   _syncAttempt.begin(AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms);
-  return State::RequestLastValues;
+  /* Request the last values right away, without waiting for the next update */
+  return handleRequestLastValues();
 }
 
 ArduinoCloudThing::State ArduinoCloudThing::handleRequestLastValues() {
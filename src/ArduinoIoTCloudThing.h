@@ -40,6 +40,18 @@ public:
   inline unsigned int &getPropertyContainerIndex() {
     return _propertyContainerIndex;
   }
+  inline void setBackoffPolicy(TimedAttempt::BackoffPolicy policy, uint32_t seed) {
+    _syncAttempt.setBackoffPolicy(policy, seed);
+  }
+  inline bool isSynced() const {
+    return _state == State::Connected;
+  }
+  /* Skip the last values request after a reset: the values are still in sync and
+   * the writes sent by the cloud in the meantime are delivered by the broker.
+   */
+  inline void resume() {
+    _state = State::Connected;
+  }
 
 private:
 
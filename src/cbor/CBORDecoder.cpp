@@ -56,6 +56,7 @@ void CBORDecoder::decode(PropertyContainer & property_container, uint8_t const *
 
     switch (current_state) {
       case MapParserState::EnterMap     : next_state = handle_EnterMap(&map_iter, &value_iter); break;
+      case MapParserState::CompactRecord: next_state = handle_CompactRecord(&value_iter, map_data, property_container); break;
       case MapParserState::MapKey       : next_state = handle_MapKey(&value_iter); break;
       case MapParserState::UndefinedKey : next_state = handle_UndefinedKey(&value_iter); break;
       case MapParserState::BaseVersion  : next_state = handle_BaseVersion(&value_iter, map_data); break;
@@ -86,11 +87,52 @@ CBORDecoder::MapParserState CBORDecoder::handle_EnterMap(CborValue * map_iter, C
     if (cbor_value_enter_container(map_iter, value_iter) == CborNoError) {
       next_state = MapParserState::MapKey;
     }
+  } else if (cbor_value_get_type(map_iter) == CborArrayType) {
+    if (cbor_value_enter_container(map_iter, value_iter) == CborNoError) {
+      next_state = MapParserState::CompactRecord;
+    }
   }
 
   return next_state;
 }
 
+CBORDecoder::MapParserState CBORDecoder::handle_CompactRecord(CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container) {
+  /* Compact records are positional arrays: [name, value] or [name, value, time]
+     Example [["temperature", 25], [257, true, 1718000000]]
+  */
+  if (handle_Name(value_iter, map_data, property_container) != MapParserState::MapKey) {
+    return MapParserState::Error;
+  }
+
+  /* The value type is implied by its CBOR major type */
+  MapParserState value_state = MapParserState::Error;
+  if (cbor_value_is_text_string(value_iter)) {
+    value_state = handle_StringValue(value_iter, map_data);
+  } else if (cbor_value_is_boolean(value_iter)) {
+    value_state = handle_BooleanValue(value_iter, map_data);
+  } else {
+    value_state = handle_Value(value_iter, map_data);
+  }
+  if (value_state != MapParserState::MapKey) {
+    return MapParserState::Error;
+  }
+
+  if (!cbor_value_at_end(value_iter)) {
+    if (handle_Time(value_iter, map_data) != MapParserState::MapKey) {
+      return MapParserState::Error;
+    }
+  }
+
+  /* Skip any trailing item this version does not know about */
+  while (!cbor_value_at_end(value_iter)) {
+    if (cbor_value_advance(value_iter) != CborNoError) {
+      return MapParserState::Error;
+    }
+  }
+
+  return MapParserState::LeaveMap;
+}
+
 CBORDecoder::MapParserState CBORDecoder::handle_MapKey(CborValue * value_iter) {
   MapParserState next_state = MapParserState::Error;
 
@@ -39,7 +39,7 @@ class CBORDecoder
 
 public:
 
-  /* decode a CBOR payload received from the cloud */
+  /* decode a CBOR payload received from the cloud, records can be either SenML maps or compact positional arrays */
   static void decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage = false);
 
 
@@ -50,6 +50,7 @@ private:
 
   enum class MapParserState {
     EnterMap,
+    CompactRecord,
     MapKey,
     UndefinedKey,
     BaseVersion,
@@ -66,6 +67,7 @@ private:
   };
 
   static MapParserState handle_EnterMap(CborValue * map_iter, CborValue * value_iter);
+  static MapParserState handle_CompactRecord(CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container);
   static MapParserState handle_MapKey(CborValue * value_iter);
   static MapParserState handle_UndefinedKey(CborValue * value_iter);
   static MapParserState handle_BaseVersion(CborValue * value_iter, CborMapData & map_data);
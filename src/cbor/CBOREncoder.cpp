@@ -25,6 +25,7 @@
 #undef min
 #include <algorithm>
 #include <iterator>
+#include <vector>
 
 #include "lib/tinycbor/cbor-lib.h"
 
@@ -32,7 +33,7 @@
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
-CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload)
+CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload, bool compactRecords)
 {
   EncoderState current_state = EncoderState::InitPropertyEncoder,
                next_state = EncoderState::InitPropertyEncoder;
@@ -44,7 +45,7 @@ CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t *
     switch (current_state) {
       case EncoderState::InitPropertyEncoder      : next_state = handle_InitPropertyEncoder(propertyEncoder); break;
       case EncoderState::OpenCBORContainer        : next_state = handle_OpenCBORContainer(propertyEncoder, data, size); break;
-      case EncoderState::TryAppend                : next_state = handle_TryAppend(propertyEncoder, lightPayload); break;
+      case EncoderState::TryAppend                : next_state = handle_TryAppend(propertyEncoder, lightPayload, compactRecords); break;
       case EncoderState::OutOfMemory              : next_state = handle_OutOfMemory(propertyEncoder); break;
       case EncoderState::SkipProperty             : next_state = handle_SkipProperty(propertyEncoder); break;
       case EncoderState::TrimAppend               : next_state = handle_TrimAppend(propertyEncoder); break;
@@ -63,6 +64,138 @@ CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t *
   else
     bytes_encoded = 0;
 
+  if ((propertyEncoder.encoded_property_count == 0) && (propertyEncoder.skipped_property_count > 0))
+    return CborErrorOutOfMemory;
+
+  return CborNoError;
+}
+
+CborError CBOREncoder::encodePacked(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, bool lightPayload, bool compactRecords)
+{
+  bytes_encoded = 0;
+
+  /* Leave room for the CBOR indefinite length array start and break bytes */
+  if (size <= 2)
+    return CborErrorOutOfMemory;
+  size_t const capacity = size - 2;
+
+  /* Measure the pending properties using the output buffer as scratch area */
+  std::vector<Property *> candidates;
+  std::vector<size_t> weights;
+  std::vector<unsigned long> values;
+
+  std::for_each(property_container.begin(),
+                property_container.end(),
+                [&](Property * p)
+                {
+                  if (p->shouldBeUpdated() && p->isReadableByCloud())
+                  {
+                    size_t const weight = p->appendSize(data, size, lightPayload, compactRecords);
+                    if (weight > 0 && weight <= capacity)
+                    {
+                      candidates.push_back(p);
+                      weights.push_back(weight);
+                      values.push_back(weight * (1 + static_cast<unsigned long>(p->schedulingPriority())) * (1 + p->getDeferredUpdateCount()));
+                    }
+                  }
+                });
+
+  if (candidates.empty())
+    return CborNoError;
+
+  /* 0/1 knapsack over the frame capacity: best_value[c] holds the highest value achievable using c bytes,
+   * take[i * (capacity + 1) + c] records whether candidate i is part of the solution for c bytes.
+   */
+  size_t const num_candidates = candidates.size();
+  std::vector<unsigned long> best_value(capacity + 1, 0);
+  std::vector<bool> take(num_candidates * (capacity + 1), false);
+
+  for (size_t i = 0; i < num_candidates; i++)
+  {
+    for (size_t c = capacity; c >= weights[i]; c--)
+    {
+      unsigned long const value = best_value[c - weights[i]] + values[i];
+      if (value > best_value[c])
+      {
+        best_value[c] = value;
+        take[i * (capacity + 1) + c] = true;
+      }
+    }
+  }
+
+  std::vector<bool> selected(num_candidates, false);
+  for (size_t i = num_candidates, c = capacity; i-- > 0; )
+  {
+    if (take[i * (capacity + 1) + c])
+    {
+      selected[i] = true;
+      c -= weights[i];
+    }
+  }
+
+  /* Encode the selected properties preserving the container order */
+  CborEncoder encoder, arrayEncoder;
+  cbor_encoder_init(&encoder, data, size, 0);
+  CHECK_CBOR(cbor_encoder_create_array(&encoder, &arrayEncoder, CborIndefiniteLength));
+  for (size_t i = 0; i < num_candidates; i++)
+  {
+    if (selected[i])
+      CHECK_CBOR(candidates[i]->append(&arrayEncoder, lightPayload, compactRecords));
+  }
+  CHECK_CBOR(cbor_encoder_close_container(&encoder, &arrayEncoder));
+
+  /* Cleanup the _has_been_appended_but_not_sended flag of the encoded properties and age the ones left out */
+  for (size_t i = 0; i < num_candidates; i++)
+  {
+    if (selected[i])
+      candidates[i]->appendCompleted();
+    else
+      candidates[i]->deferUpdate();
+  }
+
+  bytes_encoded = cbor_encoder_get_buffer_size(&encoder, data);
+  return CborNoError;
+}
+
+CborError CBOREncoder::encodeToSink(PropertyContainer & property_container, uint8_t * data, size_t const size, std::function<bool(size_t const)> const & begin, CborChunkSink const & sink, size_t & bytes_encoded, bool lightPayload, bool compactRecords)
+{
+  bytes_encoded = 0;
+
+  std::list<Property *> pending;
+  std::copy_if(property_container.begin(),
+               property_container.end(),
+               std::back_inserter(pending),
+               [](Property * p)
+               {
+                 return p->shouldBeUpdated() && p->isReadableByCloud();
+               });
+
+  if (pending.empty())
+    return CborNoError;
+
+  /* First pass: measure the message through a sink which only counts the bytes */
+  size_t message_size = 0;
+  CborChunkSink const measure = [&message_size](uint8_t const * /* chunk */, size_t const length)
+  {
+    message_size += length;
+    return true;
+  };
+  CHECK_CBOR(encodeRecordsToSink(pending, data, size, measure, lightPayload, compactRecords));
+
+  /* Second pass: deliver the message */
+  if (!begin(message_size))
+    return CborErrorIO;
+  CHECK_CBOR(encodeRecordsToSink(pending, data, size, sink, lightPayload, compactRecords));
+
+  std::for_each(pending.begin(),
+                pending.end(),
+                [](Property * p)
+                {
+                  p->appendCommit();
+                  p->appendCompleted();
+                });
+
+  bytes_encoded = message_size;
   return CborNoError;
 }
 
@@ -73,48 +206,81 @@ CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t *
 CBOREncoder::EncoderState CBOREncoder::handle_InitPropertyEncoder(PropertyContainerEncoder & propertyEncoder)
 {
   propertyEncoder.encoded_property_count = 0;
-  propertyEncoder.checked_property_count = 0;
+  propertyEncoder.next_property_index = propertyEncoder.current_property_index;
+  propertyEncoder.failed_property = nullptr;
+  propertyEncoder.skipped_property_count = 0;
   propertyEncoder.encoded_property_limit = 0;
   propertyEncoder.property_limit_active  = false;
+  std::for_each(propertyEncoder.property_container.begin(),
+                propertyEncoder.property_container.end(),
+                [](Property * p)
+                {
+                  p->setSkippedFromMessage(false);
+                });
   return EncoderState::OpenCBORContainer;
 }
 
 CBOREncoder::EncoderState CBOREncoder::handle_OpenCBORContainer(PropertyContainerEncoder & propertyEncoder, uint8_t * data, size_t const size)
 {
   propertyEncoder.encoded_property_count = 0;
-  propertyEncoder.checked_property_count = 0;
+  propertyEncoder.next_property_index = propertyEncoder.current_property_index;
+  std::for_each(propertyEncoder.property_container.begin(),
+                propertyEncoder.property_container.end(),
+                [](Property * p)
+                {
+                  p->setAppendedToMessage(false);
+                });
   cbor_encoder_init(&propertyEncoder.encoder, data, size, 0);
   cbor_encoder_create_array(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder, CborIndefiniteLength);
   return EncoderState::TryAppend;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload)
+CBOREncoder::EncoderState CBOREncoder::handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload, bool & compactRecords)
 {
   /* Check if backing storage and cloud has diverged. Time interval may be elapsed or property may be changed
-   * and if that's the case encode the property into the CBOR.
+   * and if that's the case encode the property into the CBOR. Pending properties are served class by class
+   * starting from the highest priority, each class round-robin starting from current_property_index.
    */
   CborError error = CborNoError;
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
+  unsigned int const property_count = propertyEncoder.property_container.size();
+  bool stop_append = false;
 
-  for(; iter != propertyEncoder.property_container.end(); iter++)
+  if (propertyEncoder.current_property_index >= property_count)
+    propertyEncoder.current_property_index = 0;
+
+  for(int priority = static_cast<int>(Priority::High); (priority >= static_cast<int>(Priority::Low)) && !stop_append; priority--)
   {
-    Property * p = * iter;
+    PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
+    std::advance(iter, propertyEncoder.current_property_index);
 
-    if (p->shouldBeUpdated() && p->isReadableByCloud())
+    for(unsigned int checked = 0; (checked < property_count) && !stop_append; checked++, iter++)
     {
-      error = p->append(&propertyEncoder.arrayEncoder, lightPayload);
-      if(error == CborNoError)
-        propertyEncoder.encoded_property_count++;
+      if (iter == propertyEncoder.property_container.end())
+        iter = propertyEncoder.property_container.begin();
+
+      Property * p = * iter;
+
+      if ((static_cast<int>(p->schedulingPriority()) != priority) || p->isSkippedFromMessage())
+        continue;
+
+      if (p->shouldBeUpdated() && p->isReadableByCloud())
+      {
+        error = p->append(&propertyEncoder.arrayEncoder, lightPayload, compactRecords);
+        if(error == CborNoError) {
+          propertyEncoder.encoded_property_count++;
+          p->setAppendedToMessage(true);
+          p->setOversized(false);
+          propertyEncoder.next_property_index = (propertyEncoder.current_property_index + checked + 1) % property_count;
+        } else {
+          propertyEncoder.failed_property = p;
+        }
+      }
+
+      bool const maximum_number_of_properties_reached = (propertyEncoder.encoded_property_count >= propertyEncoder.encoded_property_limit) && (propertyEncoder.property_limit_active == true);
+      bool const cbor_encoder_error = (error != CborNoError);
+
+      stop_append = maximum_number_of_properties_reached || cbor_encoder_error;
     }
-    if(error == CborNoError)
-      propertyEncoder.checked_property_count++;
-
-    bool const maximum_number_of_properties_reached = (propertyEncoder.encoded_property_count >= propertyEncoder.encoded_property_limit) && (propertyEncoder.property_limit_active == true);
-    bool const cbor_encoder_error = (error != CborNoError);
-
-    if (maximum_number_of_properties_reached || cbor_encoder_error)
-      break;
   }
 
   if (CborErrorOutOfMemory == error)
@@ -137,13 +303,14 @@ CBOREncoder::EncoderState CBOREncoder::handle_OutOfMemory(PropertyContainerEncod
 
 CBOREncoder::EncoderState CBOREncoder::handle_SkipProperty(PropertyContainerEncoder & propertyEncoder)
 {
-  /* Better to skip this property otherwise we will stay blocked here. This happens only with a message property 
-   * that doesn't fit into the CBOR buffer
+  /* Better to skip this property otherwise we will stay blocked here. This happens only with a property
+   * that doesn't fit into an empty message: the message is encoded again without it, so that the other
+   * properties, of its class and of the lower ones, are still sent.
    */
-  propertyEncoder.current_property_index++;
-  if(propertyEncoder.current_property_index >= propertyEncoder.property_container.size())
-    propertyEncoder.current_property_index = 0;
-  return EncoderState::Error;
+  propertyEncoder.failed_property->setSkippedFromMessage(true);
+  propertyEncoder.failed_property->setOversized(true);
+  propertyEncoder.skipped_property_count++;
+  return EncoderState::OpenCBORContainer;
 }
 
 CBOREncoder::EncoderState CBOREncoder::handle_TrimAppend(PropertyContainerEncoder & propertyEncoder)
@@ -182,26 +349,48 @@ CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEnco
   /* Restore property message limit to CBOR_ENCODER_NO_PROPERTIES_LIMIT */
   propertyEncoder.property_limit_active = false;
 
-  /* The append process has been successful, so we don't need to try to send this properties set. Cleanup _has_been_appended_but_not_sended flag */
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
-  int num_appended_properties = 0;
+  /* The append process has been successful, so we don't need to try to send this properties set. Cleanup _has_been_appended_but_not_sended
+   * flag of the appended properties and age the pending ones which did not fit into this message, the oversized ones excepted.
+   */
+  std::for_each(propertyEncoder.property_container.begin(),
+                propertyEncoder.property_container.end(),
+                [](Property * p)
+                {
+                  if (p->isAppendedToMessage())
+                    p->appendCompleted();
+                  else if (p->shouldBeUpdated() && p->isReadableByCloud())
+                    p->deferUpdate();
+                });
 
-  for(; iter != propertyEncoder.property_container.end(); iter++)
-  {
-    Property * p = * iter;
-    if (num_appended_properties >= propertyEncoder.checked_property_count)
-      break;
+  /* Advance property index for the next message */
+  propertyEncoder.current_property_index = propertyEncoder.next_property_index;
 
-    p->appendCompleted();
-    num_appended_properties++;
-  }
+  return EncoderState::SendMessage;
+}
 
-  /* Advance property index for the next message */
-  propertyEncoder.current_property_index += propertyEncoder.checked_property_count;
+CborError CBOREncoder::encodeRecordsToSink(std::list<Property *> const & properties, uint8_t * data, size_t const size, CborChunkSink const & sink, bool lightPayload, bool compactRecords)
+{
+  CborEncoder encoder, arrayEncoder;
+  cbor_encoder_init(&encoder, data, size, 0);
+  CHECK_CBOR(cbor_encoder_create_array(&encoder, &arrayEncoder, CborIndefiniteLength));
 
-  if(propertyEncoder.current_property_index >= propertyEncoder.property_container.size())
-    propertyEncoder.current_property_index = 0;
+  for (Property * p : properties)
+  {
+    /* Each record starts from an empty chunk buffer, so only strings have to be split */
+    CHECK_CBOR(flushToSink(arrayEncoder, data, sink));
+    CHECK_CBOR(p->appendToSink(&arrayEncoder, data, sink, lightPayload, compactRecords));
+  }
 
-  return EncoderState::SendMessage;
+  CHECK_CBOR(flushToSink(arrayEncoder, data, sink));
+  CHECK_CBOR(cbor_encoder_close_container(&encoder, &arrayEncoder));
+  return flushToSink(encoder, data, sink);
+}
+
+CborError CBOREncoder::flushToSink(CborEncoder & encoder, uint8_t * data, CborChunkSink const & sink)
+{
+  size_t const length = cbor_encoder_get_buffer_size(&encoder, data);
+  if (length > 0 && !sink(data, length))
+    return CborErrorIO;
+  encoder.data.ptr = data;
+  return CborNoError;
 }
@@ -40,7 +40,17 @@ class CBOREncoder
 public:
     /* encode return > 0 if a property has changed and encodes the changed properties in CBOR format into the provided buffer */
     /* if lightPayload is true the integer identifier of the property will be encoded in the message instead of the property name in order to reduce the size of the message payload*/
-    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false);
+    /* if compactRecords is true each record is encoded as a positional array [name, value] or [name, value, time] instead of a SenML map. The peer must support it */
+    /* properties are encoded by priority class, starting from the highest one. Within each class properties are served round-robin starting from current_property_index */
+    /* properties which don't fit into an empty message are skipped, CborErrorOutOfMemory is returned if no other property could be encoded */
+    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false, bool compactRecords = false);
+    /* encodePacked selects the subset of changed properties which makes the best use of the provided buffer, weighting each property by its priority and by
+     * the number of messages it has been left out of, instead of stopping at the first property which doesn't fit. Intended for size constrained LPWAN frames */
+    static CborError encodePacked(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, bool lightPayload = false, bool compactRecords = false);
+    /* encodeToSink encodes all the changed properties into a single message of unbounded size, so that properties larger than the provided
+     * buffer are not skipped. The buffer is only used as chunk buffer and handed over to the sink whenever it has to be reused. The message
+     * is encoded twice: the first pass measures it and begin is called with its total size before the first chunk reaches the sink */
+    static CborError encodeToSink(PropertyContainer & property_container, uint8_t * data, size_t const size, std::function<bool(size_t const)> const & begin, CborChunkSink const & sink, size_t & bytes_encoded, bool lightPayload = false, bool compactRecords = false);
 
 private:
 
@@ -68,7 +78,9 @@ private:
     PropertyContainer & property_container;
     unsigned int & current_property_index;
     int encoded_property_count;
-    int checked_property_count;
+    unsigned int next_property_index;
+    Property * failed_property;
+    int skipped_property_count;
     int encoded_property_limit;
     bool property_limit_active;
     CborEncoder encoder;
@@ -77,7 +89,7 @@ private:
 
   static EncoderState handle_InitPropertyEncoder(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_OpenCBORContainer(PropertyContainerEncoder & propertyEncoder, uint8_t * data, size_t const size);
-  static EncoderState handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload);
+  static EncoderState handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload, bool & compactRecords);
   static EncoderState handle_OutOfMemory(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_SkipProperty(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_TrimAppend(PropertyContainerEncoder & propertyEncoder);
@@ -86,6 +98,9 @@ private:
   static EncoderState handle_FinishAppend(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_AdvancePropertyContainer(PropertyContainerEncoder & propertyEncoder);
 
+  static CborError encodeRecordsToSink(std::list<Property *> const & properties, uint8_t * data, size_t const size, CborChunkSink const & sink, bool lightPayload, bool compactRecords);
+  static CborError flushToSink(CborEncoder & encoder, uint8_t * data, CborChunkSink const & sink);
+
 };
 
 #endif /* ARDUINO_CBOR_CBOR_ENCODER_H_ */
@@ -0,0 +1,53 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include <property/PropertyContainer.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+class Outbox {
+public:
+  virtual ~Outbox() { }
+
+  /**
+   * Snapshot the changed properties stamped with time and mark them as sent
+   * @param property_container: the properties to be recorded
+   * @param time: the timestamp encoded into the recorded snapshots
+   * @param lightPayload: encode the property identifiers instead of the names
+   * @param compactRecords: encode the records as positional arrays
+   */
+  virtual void record(PropertyContainer & property_container, unsigned long const time, bool lightPayload = false, bool compactRecords = false) = 0;
+
+  /**
+   * Encode the oldest queued snapshots which fit into a single message
+   * @param data: the buffer the message will be encoded into
+   * @param size: the size of the provided buffer
+   * @param bytes_encoded: the size of the encoded message
+   * @return the number of snapshots encoded into the message
+   */
+  virtual size_t encode(uint8_t * data, size_t const size, int & bytes_encoded) = 0;
+
+  /**
+   * Remove the oldest snapshots once the message carrying them has been delivered
+   * @param count: the number of snapshots to be removed
+   */
+  virtual void release(size_t const count) = 0;
+
+  virtual bool isEmpty() const = 0;
+};
@@ -0,0 +1,65 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+/******************************************************************************
+ * INCLUDES
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Storage with NOR flash semantics backing a PersistentOutbox: it is erased a
+ * sector at a time, erased bytes read as 0xFF and writing can only clear bits.
+ */
+class OutboxStorage {
+public:
+  virtual ~OutboxStorage() { }
+
+  /**
+   * @return the size in bytes of an erase unit
+   */
+  virtual size_t sectorSize() const = 0;
+
+  /**
+   * @return the number of sectors available
+   */
+  virtual size_t sectorCount() const = 0;
+
+  /**
+   * Read from the storage
+   * @param address: the offset from the start of the first sector
+   * @param data: the buffer the data will be read into
+   * @param len: the number of bytes to read
+   * @return true on success
+   */
+  virtual bool read(size_t const address, uint8_t * data, size_t const len) = 0;
+
+  /**
+   * Program the storage, only bits set in the storage can be cleared
+   * @param address: the offset from the start of the first sector
+   * @param data: the data to be written
+   * @param len: the number of bytes to write
+   * @return true on success
+   */
+  virtual bool write(size_t const address, uint8_t const * data, size_t const len) = 0;
+
+  /**
+   * Erase a sector, setting all of its bytes to 0xFF
+   * @param sector: the index of the sector
+   * @return true on success
+   */
+  virtual bool erase(size_t const sector) = 0;
+};
@@ -0,0 +1,408 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PersistentOutbox.h"
+
+#undef max
+#undef min
+#include <algorithm>
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static uint8_t const SECTOR_MAGIC[]     = {0x4F, 0x42};
+static uint8_t const SECTOR_VERSION     = 0x01;
+static size_t const  SECTOR_HEADER_SIZE = 8;
+static size_t const  ENTRY_HEADER_SIZE  = 4;
+static uint16_t const ENTRY_ERASED_LENGTH = 0xFFFF;
+
+/* Entry states, each one is reached from the previous one by clearing bits */
+static uint8_t const ENTRY_WRITTEN  = 0xFF;
+static uint8_t const ENTRY_VALID    = 0x7F;
+static uint8_t const ENTRY_CONSUMED = 0x3F;
+
+static uint8_t const CBOR_INDEFINITE_ARRAY_START = 0x9F;
+static uint8_t const CBOR_BREAK                  = 0xFF;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+PersistentOutbox::PersistentOutbox(size_t const message_size)
+: _storage{nullptr}
+, _message_size{message_size}
+, _head{0, SECTOR_HEADER_SIZE}
+, _tail{0, SECTOR_HEADER_SIZE}
+, _has_tail{false}
+, _sequence{0}
+, _count{0}
+, _dropped_count{0}
+, _bandwidth_limit{0}
+, _bandwidth_tokens{0}
+, _bandwidth_refill_ms{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool PersistentOutbox::begin(OutboxStorage & storage)
+{
+  _storage = nullptr;
+  _head = {0, SECTOR_HEADER_SIZE};
+  _tail = {0, SECTOR_HEADER_SIZE};
+  _has_tail = false;
+  _sequence = 0;
+  _count = 0;
+
+  /* At least two sectors are needed so that one can be erased while the other keeps the queue */
+  if ((storage.sectorCount() < 2) || (storage.sectorSize() < (SECTOR_HEADER_SIZE + ENTRY_HEADER_SIZE + _message_size)))
+    return false;
+
+  _storage = &storage;
+  _scratch.resize(_message_size);
+  _bandwidth_tokens = 0;
+  _bandwidth_refill_ms = millis();
+
+  /* The oldest sector in use is the head of the log, the newest one is its tail */
+  uint32_t head_sequence = 0;
+  bool has_head = false;
+  for (size_t sector = 0; sector < _storage->sectorCount(); sector++)
+  {
+    uint32_t sequence = 0;
+    if (!readSectorHeader(sector, sequence))
+      continue;
+    if (!_has_tail || (sequence > _sequence)) {
+      _tail.sector = sector;
+      _sequence = sequence;
+      _has_tail = true;
+    }
+    if (!has_head || (sequence < head_sequence)) {
+      _head.sector = sector;
+      head_sequence = sequence;
+      has_head = true;
+    }
+  }
+
+  if (!_has_tail)
+    return true;
+
+  /* Walk the log from head to tail counting the queued entries and dropping the ones corrupted by a reset */
+  _tail.offset = _storage->sectorSize();
+  Position pos = {_head.sector, SECTOR_HEADER_SIZE};
+  for (;;)
+  {
+    uint32_t sequence = 0;
+    EntryHeader header = {0, 0, 0};
+    if (readSectorHeader(pos.sector, sequence))
+    {
+      while (readEntryHeader(pos, header))
+      {
+        if (header.state == ENTRY_VALID)
+        {
+          if ((header.length <= _scratch.size()) &&
+              _storage->read(address(pos) + ENTRY_HEADER_SIZE, _scratch.data(), header.length) &&
+              (checksum(_scratch.data(), header.length) == header.checksum)) {
+            _count++;
+          } else {
+            writeState(pos, ENTRY_CONSUMED);
+          }
+        }
+        pos.offset += ENTRY_HEADER_SIZE + header.length;
+      }
+    }
+
+    if (pos.sector == _tail.sector)
+    {
+      /* New entries are appended after the last one, unless the log end is not erased */
+      _tail.offset = (header.length == ENTRY_ERASED_LENGTH) ? pos.offset : _storage->sectorSize();
+      break;
+    }
+    pos = {nextSector(pos.sector), SECTOR_HEADER_SIZE};
+  }
+
+  _head.offset = SECTOR_HEADER_SIZE;
+  if (_count == 0)
+    _head = _tail;
+
+  return true;
+}
+
+void PersistentOutbox::record(PropertyContainer & property_container, unsigned long const time, bool lightPayload, bool compactRecords)
+{
+  /* Leave room for the array start and break bytes of the message */
+  if ((_storage == nullptr) || (_message_size <= 2))
+    return;
+
+  std::for_each(property_container.begin(),
+                property_container.end(),
+                [&](Property * p)
+                {
+                  if (!p->shouldBeUpdated() || !p->isReadableByCloud())
+                    return;
+
+                  size_t const snapshot_size = p->appendSnapshot(_scratch.data(), _message_size - 1, time, lightPayload, compactRecords);
+                  if ((snapshot_size == 0) || !push(_scratch.data(), snapshot_size))
+                    return;
+
+                  p->appendCommit();
+                  p->appendCompleted();
+                });
+}
+
+bool PersistentOutbox::push(uint8_t const * records, size_t const length)
+{
+  if ((_storage == nullptr) || (length == 0) || ((length + 2) > _message_size))
+    return false;
+
+  if (!_has_tail || ((_tail.offset + ENTRY_HEADER_SIZE + length) > _storage->sectorSize()))
+  {
+    if (!advanceTail())
+      return false;
+  }
+
+  uint8_t const header[ENTRY_HEADER_SIZE] = {
+    static_cast<uint8_t>(length & 0xFF),
+    static_cast<uint8_t>(length >> 8),
+    ENTRY_WRITTEN,
+    checksum(records, length)
+  };
+
+  /* The entry space is never reused, even if writing fails. The entry becomes
+   * valid only once completely written, a reset in between leaves it ignored.
+   */
+  Position const pos = _tail;
+  _tail.offset += ENTRY_HEADER_SIZE + length;
+
+  if (!_storage->write(address(pos), header, sizeof(header)) ||
+      !_storage->write(address(pos) + ENTRY_HEADER_SIZE, records, length) ||
+      !writeState(pos, ENTRY_VALID))
+    return false;
+
+  if (_count == 0)
+    _head = pos;
+  _count++;
+  return true;
+}
+
+size_t PersistentOutbox::encode(uint8_t * data, size_t const size, int & bytes_encoded)
+{
+  bytes_encoded = 0;
+
+  if ((_storage == nullptr) || (_count == 0) || (size <= 2))
+    return 0;
+
+  size_t const budget = refillBandwidth(size);
+  size_t count = 0;
+  size_t offset = 1;
+  Position pos = _head;
+  EntryHeader header;
+
+  while ((count < _count) && findValid(pos, header))
+  {
+    if (((offset + header.length + 1) > size) || ((offset + header.length + 1) > budget))
+      break;
+    if (!_storage->read(address(pos) + ENTRY_HEADER_SIZE, data + offset, header.length) ||
+        (checksum(data + offset, header.length) != header.checksum))
+    {
+      /* An entry which can't be read back would block the log forever: once it is the
+       * oldest one it is dropped, otherwise the message ends before it.
+       */
+      if (count > 0)
+        break;
+      writeState(pos, ENTRY_CONSUMED);
+      pos.offset += ENTRY_HEADER_SIZE + header.length;
+      _head = pos;
+      _count--;
+      _dropped_count++;
+      continue;
+    }
+    offset += header.length;
+    pos.offset += ENTRY_HEADER_SIZE + header.length;
+    count++;
+  }
+
+  if (count > 0)
+  {
+    data[0] = CBOR_INDEFINITE_ARRAY_START;
+    data[offset++] = CBOR_BREAK;
+    bytes_encoded = offset;
+    if (_bandwidth_limit > 0)
+      _bandwidth_tokens -= offset * 1000;
+  }
+
+  return count;
+}
+
+void PersistentOutbox::release(size_t const count)
+{
+  EntryHeader header;
+
+  for (size_t i = 0; (i < count) && (_count > 0); i++)
+  {
+    if (!findValid(_head, header))
+      break;
+    writeState(_head, ENTRY_CONSUMED);
+    _head.offset += ENTRY_HEADER_SIZE + header.length;
+    _count--;
+  }
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool PersistentOutbox::readSectorHeader(size_t const sector, uint32_t & sequence)
+{
+  uint8_t header[SECTOR_HEADER_SIZE];
+  if (!_storage->read(sector * _storage->sectorSize(), header, sizeof(header)))
+    return false;
+  if ((header[0] != SECTOR_MAGIC[0]) || (header[1] != SECTOR_MAGIC[1]) || (header[2] != SECTOR_VERSION))
+    return false;
+  sequence = static_cast<uint32_t>(header[4])
+           | (static_cast<uint32_t>(header[5]) << 8)
+           | (static_cast<uint32_t>(header[6]) << 16)
+           | (static_cast<uint32_t>(header[7]) << 24);
+  return true;
+}
+
+bool PersistentOutbox::readEntryHeader(Position const & pos, EntryHeader & header)
+{
+  header.length = 0;
+
+  if ((pos.sector == _tail.sector) && (pos.offset >= _tail.offset))
+    return false;
+  if ((pos.offset + ENTRY_HEADER_SIZE) > _storage->sectorSize())
+    return false;
+
+  uint8_t raw[ENTRY_HEADER_SIZE];
+  if (!_storage->read(address(pos), raw, sizeof(raw)))
+    return false;
+
+  header.length   = static_cast<uint16_t>(raw[0] | (raw[1] << 8));
+  header.state    = raw[2];
+  header.checksum = raw[3];
+
+  if ((header.length == ENTRY_ERASED_LENGTH) || (header.length == 0))
+    return false;
+  if ((pos.offset + ENTRY_HEADER_SIZE + header.length) > _storage->sectorSize())
+    return false;
+
+  return true;
+}
+
+bool PersistentOutbox::findValid(Position & pos, EntryHeader & header)
+{
+  for (;;)
+  {
+    while (readEntryHeader(pos, header))
+    {
+      if (header.state == ENTRY_VALID)
+        return true;
+      pos.offset += ENTRY_HEADER_SIZE + header.length;
+    }
+
+    if (pos.sector == _tail.sector)
+      return false;
+    pos = {nextSector(pos.sector), SECTOR_HEADER_SIZE};
+  }
+}
+
+size_t PersistentOutbox::countValid(size_t const sector)
+{
+  size_t count = 0;
+  Position pos = {sector, SECTOR_HEADER_SIZE};
+  EntryHeader header;
+
+  while (readEntryHeader(pos, header))
+  {
+    if (header.state == ENTRY_VALID)
+      count++;
+    pos.offset += ENTRY_HEADER_SIZE + header.length;
+  }
+  return count;
+}
+
+bool PersistentOutbox::advanceTail()
+{
+  size_t const sector = _has_tail ? nextSector(_tail.sector) : _tail.sector;
+  uint32_t const sequence = _has_tail ? (_sequence + 1) : 0;
+
+  /* The log is full: the oldest sector is reused and the snapshots it still holds are lost */
+  uint32_t old_sequence = 0;
+  if (_has_tail && readSectorHeader(sector, old_sequence))
+  {
+    size_t const dropped = countValid(sector);
+    _dropped_count += dropped;
+    _count -= dropped;
+    if (_head.sector == sector)
+      _head = {nextSector(sector), SECTOR_HEADER_SIZE};
+  }
+
+  uint8_t const header[SECTOR_HEADER_SIZE] = {
+    SECTOR_MAGIC[0],
+    SECTOR_MAGIC[1],
+    SECTOR_VERSION,
+    0xFF,
+    static_cast<uint8_t>(sequence),
+    static_cast<uint8_t>(sequence >> 8),
+    static_cast<uint8_t>(sequence >> 16),
+    static_cast<uint8_t>(sequence >> 24)
+  };
+
+  if (!_storage->erase(sector) || !_storage->write(sector * _storage->sectorSize(), header, sizeof(header)))
+    return false;
+
+  _tail = {sector, SECTOR_HEADER_SIZE};
+  _sequence = sequence;
+  _has_tail = true;
+  if (_count == 0)
+    _head = _tail;
+  return true;
+}
+
+bool PersistentOutbox::writeState(Position const & pos, uint8_t const state)
+{
+  return _storage->write(address(pos) + 2, &state, 1);
+}
+
+size_t PersistentOutbox::refillBandwidth(size_t const size)
+{
+  if (_bandwidth_limit == 0)
+    return size;
+
+  /* Token bucket accounted in thousandths of byte, holding at least a full message */
+  unsigned long const now = millis();
+  unsigned long long const capacity = static_cast<unsigned long long>(std::max(_bandwidth_limit, size)) * 1000;
+  unsigned long long const tokens = _bandwidth_tokens + static_cast<unsigned long long>(now - _bandwidth_refill_ms) * _bandwidth_limit;
+  _bandwidth_tokens = static_cast<size_t>(std::min(tokens, capacity));
+  _bandwidth_refill_ms = now;
+  return _bandwidth_tokens / 1000;
+}
+
+uint8_t PersistentOutbox::checksum(uint8_t const * data, size_t const length)
+{
+  /* CRC-8, polynomial 0x07 */
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+  }
+  return crc;
+}
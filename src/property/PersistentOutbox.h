@@ -0,0 +1,104 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#ifndef ARDUINO_PERSISTENT_OUTBOX_H_
+#define ARDUINO_PERSISTENT_OUTBOX_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#undef max
+#undef min
+#include <vector>
+
+#include "PropertyContainer.h"
+#include "../interfaces/Outbox.h"
+#include "../interfaces/OutboxStorage.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Outbox keeping the property snapshots into an OutboxStorage, so that they survive a reset.
+ *
+ * The storage is used as a log: each sector starts with a header carrying a sequence number
+ * and is filled with [length, state, checksum, records] entries. Entries are never rewritten,
+ * delivered ones only get their state bits cleared, and sectors are erased one after the
+ * other in a ring so that the wear is spread evenly. When the log is full the oldest sector
+ * is erased, dropping the snapshots it holds. Every snapshot is kept, coalescing is not
+ * applied to the log.
+ */
+class PersistentOutbox : public Outbox
+{
+public:
+
+  PersistentOutbox(size_t const message_size);
+
+  /* Scan the storage and recover the queued snapshots, returns false if the storage is not usable */
+  bool begin(OutboxStorage & storage);
+  /* Limit the bytes encoded per second, 0 disables the limit */
+  inline void setBandwidthLimit(size_t const bytes_per_second) { _bandwidth_limit = bytes_per_second; }
+
+  virtual void record(PropertyContainer & property_container, unsigned long const time, bool lightPayload = false, bool compactRecords = false) override;
+  /* Append already encoded records to the log, returns false if they could not be stored */
+  bool push(uint8_t const * records, size_t const length);
+  virtual size_t encode(uint8_t * data, size_t const size, int & bytes_encoded) override;
+  virtual void release(size_t const count) override;
+
+  virtual bool  isEmpty        () const override { return _count == 0; }
+  inline bool   isReady        () const { return _storage != nullptr; }
+  inline size_t count          () const { return _count; }
+  inline size_t getDroppedCount() const { return _dropped_count; }
+
+private:
+
+  struct Position
+  {
+    size_t sector;
+    size_t offset;
+  };
+
+  struct EntryHeader
+  {
+    uint16_t length;
+    uint8_t  state;
+    uint8_t  checksum;
+  };
+
+  OutboxStorage * _storage;
+  size_t _message_size;
+  std::vector<uint8_t> _scratch;
+  Position _head;
+  Position _tail;
+  bool _has_tail;
+  uint32_t _sequence;
+  size_t _count;
+  size_t _dropped_count;
+  size_t _bandwidth_limit;
+  size_t _bandwidth_tokens;
+  unsigned long _bandwidth_refill_ms;
+
+  bool readSectorHeader(size_t const sector, uint32_t & sequence);
+  bool readEntryHeader(Position const & pos, EntryHeader & header);
+  bool findValid(Position & pos, EntryHeader & header);
+  size_t countValid(size_t const sector);
+  bool advanceTail();
+  bool writeState(Position const & pos, uint8_t const state);
+  size_t refillBandwidth(size_t const size);
+  inline size_t nextSector(size_t const sector) const { return (sector + 1) % _storage->sectorCount(); }
+  inline size_t address(Position const & pos) const { return pos.sector * _storage->sectorSize() + pos.offset; }
+
+  static uint8_t checksum(uint8_t const * data, size_t const length);
+};
+
+#endif /* ARDUINO_PERSISTENT_OUTBOX_H_ */
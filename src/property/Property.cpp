@@ -20,6 +20,49 @@
 #undef max
 #undef min
 #include <algorithm>
+#include <math.h>
+#include <string.h>
+
+/******************************************************************************
+   LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+/* Converts value into an IEEE 754 half precision float. Returns false if the conversion is not lossless. */
+static bool convertFloatToHalfFloat(float const value, uint16_t & half_val)
+{
+  uint32_t bits = 0;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint16_t const sign     = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  int32_t  const exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+  uint32_t const mantissa = (bits & 0x7FFFFF) | 0x800000;
+
+  if ((bits & 0x7FFFFFFF) == 0) {
+    /* +0.0 and -0.0 */
+    half_val = sign;
+    return true;
+  }
+
+  if (exponent >= -14 && exponent <= 15) {
+    /* Normal half float: the 13 least significant bits of the mantissa are dropped */
+    if (mantissa & 0x1FFF)
+      return false;
+    half_val = sign | static_cast<uint16_t>((exponent + 15) << 10) | static_cast<uint16_t>((mantissa >> 13) & 0x3FF);
+    return true;
+  }
+
+  if (exponent >= -24 && exponent < -14) {
+    /* Subnormal half float: value = m * 2^-24 */
+    uint32_t const shift = static_cast<uint32_t>(-1 - exponent);
+    if (mantissa & ((1UL << shift) - 1))
+      return false;
+    half_val = sign | static_cast<uint16_t>(mantissa >> shift);
+    return true;
+  }
+
+  /* Out of range, infinity or NaN */
+  return false;
+}
 
 /******************************************************************************
    CTOR/DTOR
@@ -44,10 +87,22 @@ Property::Property()
 , _identifier{0}
 , _attributeIdentifier{0}
 , _lightPayload{false}
+, _compactRecords{false}
 , _update_requested{false}
 , _encode_timestamp{false}
+, _encode_compact_float{false}
+, _float_resolution{0.0f}
 , _echo_requested{false}
 , _timestamp{0}
+, _priority{Priority::Normal}
+, _deferred_update_count{0}
+, _appended_to_message{false}
+, _skipped_from_message{false}
+, _oversized{false}
+, _coalescing{Coalescing::KeepLatest}
+, _record_name_cache_light_payload{false}
+, _stream_chunk{nullptr}
+, _stream_sink{nullptr}
 {
 
 }
@@ -67,6 +122,7 @@ void Property::init(String const name, Permission const permission, GetTimeCallb
   _name = name;
   _permission = permission;
   _get_time_func = func;
+  invalidateRecordNameCache();
 }
 
 Property & Property::onUpdate(UpdateCallbackFunc func) {
@@ -103,6 +159,13 @@ Property & Property::encodeTimestamp()
   return (*this);
 }
 
+Property & Property::encodeCompactFloat(float const resolution)
+{
+  _encode_compact_float = true;
+  _float_resolution = resolution;
+  return (*this);
+}
+
 Property & Property::writeOnChange()
 {
   _write_policy = WritePolicy::Auto;
@@ -115,6 +178,18 @@ Property & Property::writeOnDemand()
   return (*this);
 }
 
+Property & Property::priority(Priority const priority)
+{
+  _priority = priority;
+  return (*this);
+}
+
+Property & Property::coalescing(Coalescing const coalescing)
+{
+  _coalescing = coalescing;
+  return (*this);
+}
+
 void Property::setTimestamp(unsigned long const timestamp)
 {
   _timestamp = timestamp;
@@ -163,6 +238,32 @@ void Property::appendCompleted()
   if (_has_been_appended_but_not_sended) {
     _has_been_appended_but_not_sended = false;
   }
+  _deferred_update_count = 0;
+}
+
+void Property::deferUpdate()
+{
+  if (!_oversized) {
+    _deferred_update_count++;
+  }
+}
+
+void Property::setOversized(bool const oversized)
+{
+  _oversized = oversized;
+  /* Promoting a property which can't be encoded would only block the other ones */
+  if (_oversized) {
+    _deferred_update_count = 0;
+  }
+}
+
+Priority Property::schedulingPriority() const
+{
+  /* Age pending properties which have been left out of the encoded messages
+   * in order to avoid starving the lower priority classes.
+   */
+  unsigned int const scheduling_priority = static_cast<unsigned int>(_priority) + (_deferred_update_count / PRIORITY_AGING_DEFERRED_UPDATES);
+  return static_cast<Priority>(std::min(scheduling_priority, static_cast<unsigned int>(Priority::High)));
 }
 
 void Property::execCallbackOnChange() {
@@ -180,10 +281,43 @@ void Property::execCallbackOnSync() {
   }
 }
 
-CborError Property::append(CborEncoder *encoder, bool lightPayload) {
+CborError Property::append(CborEncoder *encoder, bool lightPayload, bool compactRecords) {
   _lightPayload = lightPayload;
+  _compactRecords = compactRecords;
   _attributeIdentifier = 0;
   CHECK_CBOR(appendAttributesToCloud(encoder));
+  appendCommit();
+  return CborNoError;
+}
+
+CborError Property::appendToSink(CborEncoder *encoder, uint8_t * chunk, CborChunkSink const & sink, bool lightPayload, bool compactRecords) {
+  _lightPayload = lightPayload;
+  _compactRecords = compactRecords;
+  _attributeIdentifier = 0;
+  _stream_chunk = chunk;
+  _stream_sink = &sink;
+  CborError const error = appendAttributesToCloud(encoder);
+  _stream_chunk = nullptr;
+  _stream_sink = nullptr;
+  return error;
+}
+
+size_t Property::appendSnapshot(uint8_t * data, size_t const size, unsigned long const timestamp, bool lightPayload, bool compactRecords) {
+  bool const encode_timestamp = _encode_timestamp;
+  unsigned long const property_timestamp = _timestamp;
+  _encode_timestamp = true;
+  _timestamp = timestamp;
+  size_t const snapshot_size = appendSize(data, size, lightPayload, compactRecords);
+  _encode_timestamp = encode_timestamp;
+  _timestamp = property_timestamp;
+  /* Drop the CBOR indefinite length array start byte used by appendSize */
+  if (snapshot_size > 0) {
+    memmove(data, data + 1, snapshot_size);
+  }
+  return snapshot_size;
+}
+
+void Property::appendCommit() {
   fromLocalToCloud();
   _has_been_updated_once = true;
   _has_been_modified_in_callback = false;
@@ -191,55 +325,122 @@ CborError Property::append(CborEncoder *encoder, bool lightPayload) {
   _echo_requested = false;
   _has_been_appended_but_not_sended = true;
   _last_updated_millis = millis();
-  return CborNoError;
 }
 
-CborError Property::appendAttribute(bool value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+size_t Property::appendSize(uint8_t * data, size_t const size, bool lightPayload, bool compactRecords) {
+  /* Encode the property attributes into the provided scratch buffer without
+   * updating the property state. Returns 0 if the property does not fit.
+   */
+  CborEncoder encoder, arrayEncoder;
+  cbor_encoder_init(&encoder, data, size, 0);
+  if (cbor_encoder_create_array(&encoder, &arrayEncoder, CborIndefiniteLength) != CborNoError)
+    return 0;
+  _lightPayload = lightPayload;
+  _compactRecords = compactRecords;
+  _attributeIdentifier = 0;
+  if (appendAttributesToCloud(&arrayEncoder) != CborNoError)
+    return 0;
+  /* Do not account the CBOR indefinite length array start byte */
+  return cbor_encoder_get_buffer_size(&arrayEncoder, data) - 1;
+}
+
+CborError Property::appendAttribute(bool value, String const & attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, CborIntegerMapKey::BooleanValue, [value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BooleanValue)));
     CHECK_CBOR(cbor_encode_boolean(&mapEncoder, value));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttribute(int value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(int value, String const & attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, CborIntegerMapKey::Value, [value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
     CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttribute(unsigned int value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(unsigned int value, String const & attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, CborIntegerMapKey::Value, [value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
     CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttribute(float value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(float value, String const & attributeName, CborEncoder *encoder) {
+  if (_encode_compact_float) {
+    return appendAttributeName(attributeName, CborIntegerMapKey::Value, [this, value](CborEncoder & mapEncoder)
+    {
+      CHECK_CBOR(appendCompactFloat(&mapEncoder, value));
+      return CborNoError;
+    }, encoder);
+  }
+  return appendAttributeName(attributeName, CborIntegerMapKey::Value, [value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
     CHECK_CBOR(cbor_encode_float(&mapEncoder, value));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttribute(String value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendCompactFloat(CborEncoder * mapEncoder, float value)
+{
+  if (_float_resolution > 0.0f && isfinite(value)) {
+    value = roundf(value / _float_resolution) * _float_resolution;
+  }
+
+  /* Integral values up to 32 bit are never larger than a single precision float once encoded as CBOR integer */
+  if (isfinite(value) && (value == truncf(value)) && (fabsf(value) < 4294967296.0f) && !(value == 0.0f && signbit(value))) {
+    return cbor_encode_int(mapEncoder, static_cast<int64_t>(value));
+  }
+
+  uint16_t half_val = 0;
+  if (convertFloatToHalfFloat(value, half_val)) {
+    return cbor_encode_half_float(mapEncoder, &half_val);
+  }
+
+  return cbor_encode_float(mapEncoder, value);
+}
+
+CborError Property::appendAttribute(String const & value, String const & attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, CborIntegerMapKey::StringValue, [this, &value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::StringValue)));
+    if (_stream_sink != nullptr) {
+      return appendStreamedString(&mapEncoder, value);
+    }
     CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, value.c_str()));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
+CborError Property::appendStreamedString(CborEncoder * mapEncoder, String const & value)
+{
+  size_t const length = value.length();
+
+  /* Strings which fit into the chunk buffer, header included, are encoded as usual */
+  if ((mapEncoder->end == nullptr) || (length + 9 <= static_cast<size_t>(mapEncoder->end - mapEncoder->data.ptr))) {
+    return cbor_encode_text_string(mapEncoder, value.c_str(), length);
+  }
+
+  /* A text string header is an unsigned integer header with the major type set to 3 */
+  uint8_t header[9];
+  CborEncoder headerEncoder;
+  cbor_encoder_init(&headerEncoder, header, sizeof(header), 0);
+  CHECK_CBOR(cbor_encode_uint(&headerEncoder, length));
+  header[0] |= 0x60;
+
+  /* Flush what has been encoded so far, then hand over the string without copying it into the chunk buffer */
+  if (!(*_stream_sink)(_stream_chunk, mapEncoder->data.ptr - _stream_chunk) ||
+      !(*_stream_sink)(header, cbor_encoder_get_buffer_size(&headerEncoder, header)) ||
+      !(*_stream_sink)(reinterpret_cast<uint8_t const *>(value.c_str()), length)) {
+    return CborErrorIO;
+  }
+  mapEncoder->data.ptr = _stream_chunk;
+  mapEncoder->remaining--;
+  return CborNoError;
+}
+
+CborError Property::appendAttributeName(String const & attributeName, CborIntegerMapKey const valueKey, std::function<CborError (CborEncoder& mapEncoder)> const & appendValue, CborEncoder *encoder)
 {
   if (attributeName != "") {
     // when the attribute name string is not empty, the attribute identifier is incremented in order to be encoded in the message if the _lightPayload flag is set
@@ -247,33 +448,29 @@ CborError Property::appendAttributeName(String attributeName, std::function<Cbor
   }
   CborEncoder mapEncoder;
   unsigned int num_map_properties = _encode_timestamp ? 3 : 2;
-  CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
-  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Name)));
 
-  // if _lightPayload is true, the property and attribute identifiers will be encoded instead of the property name
-  if (_lightPayload)
-  {
-    // the most significant byte of the identifier to be encoded represent the property identifier
-    int completeIdentifier = _attributeIdentifier * 256;
-    // the least significant byte of the identifier to be encoded represent the attribute identifier
-    completeIdentifier += _identifier;
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, completeIdentifier));
-  }
-  else
-  {
-    String completeName = _name;
-    if (attributeName != "") {
-      completeName += ":" + attributeName;
-    }
-    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, completeName.c_str()));
+  /* Compact records are positional arrays [name, value] or [name, value, time]:
+   * the value type is implied by its CBOR major type, so no key is encoded.
+   */
+  if (_compactRecords) {
+    CHECK_CBOR(cbor_encoder_create_array(encoder, &mapEncoder, num_map_properties));
+  } else {
+    CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
   }
+  CHECK_CBOR(appendRecordName(&mapEncoder, attributeName));
+
   /* Encode the value */
+  if (!_compactRecords) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(valueKey)));
+  }
   CHECK_CBOR(appendValue(mapEncoder));
 
   /* Encode the timestamp if that has been required. */
   if(_encode_timestamp)
   {
-    CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
+    if (!_compactRecords) {
+      CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
+    }
     CHECK_CBOR(cbor_encode_uint(&mapEncoder, _timestamp));
   }
   /* Close the container */
@@ -281,6 +478,79 @@ CborError Property::appendAttributeName(String attributeName, std::function<Cbor
   return CborNoError;
 }
 
+CborError Property::appendRecordName(CborEncoder * mapEncoder, String const & attributeName)
+{
+  if (_record_name_cache_light_payload != _lightPayload) {
+    invalidateRecordNameCache();
+    _record_name_cache_light_payload = _lightPayload;
+  }
+
+  if (_record_name_cache.size() <= static_cast<size_t>(_attributeIdentifier)) {
+    _record_name_cache.resize(_attributeIdentifier + 1);
+  }
+
+  std::vector<uint8_t> & record_name = _record_name_cache[_attributeIdentifier];
+
+  if (record_name.empty())
+  {
+    CborEncoder nameEncoder;
+    /* Worst case: 1 byte for the key, 9 bytes for the header of the integer or string value */
+    size_t const max_size = 1 + 9 + (_lightPayload ? 0 : (_name.length() + 1 + attributeName.length()));
+    std::vector<uint8_t> encoded_name(max_size);
+    cbor_encoder_init(&nameEncoder, encoded_name.data(), encoded_name.size(), 0);
+    CHECK_CBOR(cbor_encode_int(&nameEncoder, static_cast<int>(CborIntegerMapKey::Name)));
+
+    // if _lightPayload is true, the property and attribute identifiers will be encoded instead of the property name
+    if (_lightPayload)
+    {
+      // the most significant byte of the identifier to be encoded represent the property identifier
+      int completeIdentifier = _attributeIdentifier * 256;
+      // the least significant byte of the identifier to be encoded represent the attribute identifier
+      completeIdentifier += _identifier;
+      CHECK_CBOR(cbor_encode_int(&nameEncoder, completeIdentifier));
+    }
+    else
+    {
+      String completeName = _name;
+      if (attributeName != "") {
+        completeName += ":" + attributeName;
+      }
+      CHECK_CBOR(cbor_encode_text_stringz(&nameEncoder, completeName.c_str()));
+    }
+    encoded_name.resize(cbor_encoder_get_buffer_size(&nameEncoder, encoded_name.data()));
+    record_name.swap(encoded_name);
+  }
+
+  /* Compact records only carry the name item, which follows the single byte Name key */
+  uint8_t const * name_data = record_name.data();
+  size_t name_size = record_name.size();
+  if (_compactRecords) {
+    name_data++;
+    name_size--;
+  }
+
+  /* Copy the cached items into the record, mimicking the tinycbor out of memory handling */
+  mapEncoder->remaining -= _compactRecords ? 1 : 2;
+  if (mapEncoder->end == nullptr) {
+    mapEncoder->data.bytes_needed += name_size;
+    return CborErrorOutOfMemory;
+  }
+  size_t const available = mapEncoder->end - mapEncoder->data.ptr;
+  if (name_size > available) {
+    mapEncoder->data.bytes_needed = name_size - available;
+    mapEncoder->end = nullptr;
+    return CborErrorOutOfMemory;
+  }
+  memcpy(mapEncoder->data.ptr, name_data, name_size);
+  mapEncoder->data.ptr += name_size;
+  return CborNoError;
+}
+
+void Property::invalidateRecordNameCache()
+{
+  _record_name_cache.clear();
+}
+
 void Property::setAttributesFromCloud(std::list<CborMapData> * map_data_list) {
   _map_data_list = map_data_list;
   _attributeIdentifier = 0;
@@ -385,6 +655,7 @@ unsigned long Property::getLastLocalChangeTimestamp() {
 
 void Property::setIdentifier(int identifier) {
   _identifier = identifier;
+  invalidateRecordNameCache();
 }
 
 /******************************************************************************
@@ -34,6 +34,7 @@
 
 # include <functional>
 #include <list>
+#include <vector>
 
 #include "../cbor/lib/tinycbor/cbor-lib.h"
 
@@ -129,10 +130,20 @@ enum class WritePolicy {
   Auto, Manual
 };
 
+enum class Priority {
+  Low, Normal, High
+};
+
+enum class Coalescing {
+  KeepLatest, KeepAll
+};
+
 typedef void(*UpdateCallbackFunc)(void);
 typedef unsigned long(*GetTimeCallbackFunc)();
 class Property;
 typedef void(*OnSyncCallbackFunc)(Property &);
+/* Receives an encoded message chunk by chunk, returns false if the chunk could not be delivered */
+typedef std::function<bool(uint8_t const * chunk, size_t const length)> CborChunkSink;
 
 /******************************************************************************
    CLASS DECLARATION
@@ -151,8 +162,11 @@ class Property
     Property & publishEvery(unsigned long const seconds);
     Property & publishOnDemand();
     Property & encodeTimestamp();
+    Property & encodeCompactFloat(float const resolution = 0.0f);
     Property & writeOnChange();
     Property & writeOnDemand();
+    Property & priority(Priority const priority);
+    Property & coalescing(Coalescing const coalescing);
 
     inline String name() const {
       return _name;
@@ -169,11 +183,32 @@ class Property
     inline bool   isWritableOnChange() const {
       return _write_policy == WritePolicy::Auto;
     }
+    inline Priority getPriority() const {
+      return _priority;
+    }
+    inline unsigned int getDeferredUpdateCount() const {
+      return _deferred_update_count;
+    }
+    inline Coalescing getCoalescing() const {
+      return _coalescing;
+    }
 
     void setTimestamp(unsigned long const timestamp);
     bool shouldBeUpdated();
     void requestUpdate();
     void appendCompleted();
+    void deferUpdate();
+    Priority schedulingPriority() const;
+    /* State of the property within the message being encoded, set by the CBOR encoder. An oversized
+     * property doesn't fit into an empty message: it is skipped and neither aged nor promoted until
+     * it is appended again.
+     */
+    inline void setAppendedToMessage(bool const appended) { _appended_to_message = appended; }
+    inline bool isAppendedToMessage() const { return _appended_to_message; }
+    inline void setSkippedFromMessage(bool const skipped) { _skipped_from_message = skipped; }
+    inline bool isSkippedFromMessage() const { return _skipped_from_message; }
+    void setOversized(bool const oversized);
+    inline bool isOversized() const { return _oversized; }
     void provideEcho();
     void execCallbackOnChange();
     void execCallbackOnSync();
@@ -184,13 +219,23 @@ class Property
     void setIdentifier(int identifier);
 
     void updateLocalTimestamp();
-    CborError append(CborEncoder * encoder, bool lightPayload);
-    CborError appendAttribute(bool value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(unsigned int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(float value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(String value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>f, CborEncoder *encoder);
+    CborError append(CborEncoder * encoder, bool lightPayload, bool compactRecords = false);
+    /* Encode the property attributes without updating the property state. String values which don't fit
+     * into the chunk buffer are handed over to the sink straight from the property storage.
+     */
+    CborError appendToSink(CborEncoder * encoder, uint8_t * chunk, CborChunkSink const & sink, bool lightPayload, bool compactRecords = false);
+    void appendCommit();
+    /* Encode the property attributes stamped with the provided time into data, without updating the property
+     * state. Returns the size of the encoded records or 0 if they don't fit.
+     */
+    size_t appendSnapshot(uint8_t * data, size_t const size, unsigned long const timestamp, bool lightPayload = false, bool compactRecords = false);
+    size_t appendSize(uint8_t * data, size_t const size, bool lightPayload, bool compactRecords = false);
+    CborError appendAttribute(bool value, String const & attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(int value, String const & attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(unsigned int value, String const & attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(float value, String const & attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(String const & value, String const & attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttributeName(String const & attributeName, CborIntegerMapKey const valueKey, std::function<CborError (CborEncoder& mapEncoder)> const & f, CborEncoder *encoder);
     void setAttribute(String attributeName, std::function<void (CborMapData & md)>setValue);
     void setAttributesFromCloud(std::list<CborMapData> * map_data_list);
     void setAttribute(bool& value, String attributeName = "");
@@ -209,6 +254,7 @@ class Property
     };
 
     static unsigned long const DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS = 500; /* Data rate throttled to 2 Hz */
+    static unsigned int  const PRIORITY_AGING_DEFERRED_UPDATES = 4; /* A pending property is promoted by one priority class every 4 messages it has been left out of */
 
   protected:
     /* Variables used for UpdatePolicy::OnChange */
@@ -239,13 +285,37 @@ class Property
     int                _attributeIdentifier;
     /* Indicates if the property shall be encoded using the identifier instead of the name */
     bool               _lightPayload;
+    /* Indicates if the property records shall be encoded as positional arrays instead of maps */
+    bool               _compactRecords;
     /* Indicates whether a property update has been requested in case of the OnDemand update policy. */
     bool               _update_requested;
     /* Indicates whether the timestamp shall be encoded in the property or not */
     bool               _encode_timestamp;
+    /* Indicates whether float values shall be encoded using the smallest lossless CBOR representation, optionally quantized to _float_resolution */
+    bool               _encode_compact_float;
+    float              _float_resolution;
     /* Indicates if the property shall be echoed back to the cloud even if unchanged */
     bool               _echo_requested;
     unsigned long      _timestamp;
+    /* Variables used to schedule the property inside the encoded messages */
+    Priority           _priority;
+    unsigned int       _deferred_update_count;
+    bool               _appended_to_message,
+                       _skipped_from_message,
+                       _oversized;
+    /* Indicates how the updates recorded while offline are queued */
+    Coalescing         _coalescing;
+    /* Encoded name entry ({0: name} or {0: identifier}) of each attribute, reused for every record */
+    std::vector<std::vector<uint8_t>> _record_name_cache;
+    bool               _record_name_cache_light_payload;
+    /* Chunk buffer and sink used while the property is streamed by appendToSink */
+    uint8_t *          _stream_chunk;
+    CborChunkSink const * _stream_sink;
+
+    CborError appendRecordName(CborEncoder * mapEncoder, String const & attributeName);
+    CborError appendCompactFloat(CborEncoder * mapEncoder, float value);
+    CborError appendStreamedString(CborEncoder * mapEncoder, String const & value);
+    void invalidateRecordNameCache();
 };
 
 /******************************************************************************
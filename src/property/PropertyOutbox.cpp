@@ -0,0 +1,264 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PropertyOutbox.h"
+
+#undef max
+#undef min
+#include <algorithm>
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static uint8_t const CBOR_INDEFINITE_ARRAY_START = 0x9F;
+static uint8_t const CBOR_BREAK                  = 0xFF;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+PropertyOutbox::PropertyOutbox(size_t const capacity, size_t const message_size)
+: _capacity{capacity}
+, _message_size{message_size}
+, _head{0}
+, _used{0}
+, _removed_bytes{0}
+, _count{0}
+, _bytes{0}
+, _dropped_count{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PropertyOutbox::record(PropertyContainer & property_container, unsigned long const time, bool lightPayload, bool compactRecords)
+{
+  /* Leave room for the array start and break bytes of the message */
+  if ((_message_size <= 2) || (_capacity <= ENTRY_HEADER_SIZE))
+    return;
+
+  /* The outbox is only recorded into once enabled, its buffers are allocated then and never resized */
+  if (_ring.empty())
+  {
+    _ring.resize(_capacity);
+    _scratch.resize(_message_size);
+  }
+
+  std::for_each(property_container.begin(),
+                property_container.end(),
+                [&](Property * p)
+                {
+                  if (!p->shouldBeUpdated() || !p->isReadableByCloud())
+                    return;
+
+                  size_t const snapshot_size = p->appendSnapshot(_scratch.data(), _scratch.size() - 1, time, lightPayload, compactRecords);
+                  if ((snapshot_size == 0) || (snapshot_size > UINT16_MAX) || ((ENTRY_HEADER_SIZE + snapshot_size) > _capacity))
+                    return;
+
+                  if (p->getCoalescing() == Coalescing::KeepLatest)
+                    remove(p);
+
+                  push(p, _scratch.data(), snapshot_size);
+
+                  p->appendCommit();
+                  p->appendCompleted();
+                });
+}
+
+size_t PropertyOutbox::encode(uint8_t * data, size_t const size, int & bytes_encoded)
+{
+  size_t count = 0;
+  size_t offset = 1;
+  size_t pos = _head;
+  size_t remaining = _used;
+  bytes_encoded = 0;
+
+  while (remaining > 0)
+  {
+    EntryHeader const header = readHeader(pos);
+    if (header.property != nullptr)
+    {
+      if ((offset + header.length + 1) > size)
+        break;
+      readRing(wrap(pos + ENTRY_HEADER_SIZE), data + offset, header.length);
+      offset += header.length;
+      count++;
+    }
+    pos = wrap(pos + ENTRY_HEADER_SIZE + header.length);
+    remaining -= ENTRY_HEADER_SIZE + header.length;
+  }
+
+  if (count > 0)
+  {
+    data[0] = CBOR_INDEFINITE_ARRAY_START;
+    data[offset++] = CBOR_BREAK;
+    bytes_encoded = offset;
+  }
+
+  return count;
+}
+
+void PropertyOutbox::release(size_t const count)
+{
+  for (size_t i = 0; (i < count) && (_count > 0); )
+  {
+    if (readHeader(_head).property != nullptr)
+      i++;
+    popFront();
+  }
+
+  /* The removed entries reaching the front are reclaimed as well */
+  while ((_used > 0) && (readHeader(_head).property == nullptr))
+    popFront();
+}
+
+void PropertyOutbox::clear()
+{
+  _head = 0;
+  _used = 0;
+  _removed_bytes = 0;
+  _count = 0;
+  _bytes = 0;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PropertyOutbox::push(Property * property, uint8_t const * records, size_t const length)
+{
+  size_t const entry_size = ENTRY_HEADER_SIZE + length;
+
+  /* Make room reclaiming the removed entries first, then dropping the oldest snapshots */
+  while ((_capacity - _used) < entry_size)
+  {
+    if (_removed_bytes > 0) {
+      compact();
+    } else {
+      popFront();
+      _dropped_count++;
+    }
+  }
+
+  size_t const tail = wrap(_head + _used);
+  writeHeader(tail, {static_cast<uint16_t>(length), property});
+  writeRing(wrap(tail + ENTRY_HEADER_SIZE), records, length);
+  _used += entry_size;
+  _count++;
+  _bytes += length;
+}
+
+void PropertyOutbox::remove(Property * property)
+{
+  size_t pos = _head;
+  size_t remaining = _used;
+
+  while (remaining > 0)
+  {
+    EntryHeader header = readHeader(pos);
+    if (header.property == property)
+    {
+      header.property = nullptr;
+      writeHeader(pos, header);
+      _count--;
+      _bytes -= header.length;
+      _removed_bytes += ENTRY_HEADER_SIZE + header.length;
+    }
+    pos = wrap(pos + ENTRY_HEADER_SIZE + header.length);
+    remaining -= ENTRY_HEADER_SIZE + header.length;
+  }
+
+  while ((_used > 0) && (readHeader(_head).property == nullptr))
+    popFront();
+}
+
+void PropertyOutbox::popFront()
+{
+  EntryHeader const header = readHeader(_head);
+  size_t const entry_size = ENTRY_HEADER_SIZE + header.length;
+
+  if (header.property != nullptr) {
+    _count--;
+    _bytes -= header.length;
+  } else {
+    _removed_bytes -= entry_size;
+  }
+  _head = wrap(_head + entry_size);
+  _used -= entry_size;
+}
+
+void PropertyOutbox::compact()
+{
+  /* Move the queued entries over the removed ones, front to back. The destination never
+   * gets ahead of the source, so the entries can be copied in place byte by byte.
+   */
+  size_t src = _head;
+  size_t dst = _head;
+  size_t remaining = _used;
+  size_t used = 0;
+
+  while (remaining > 0)
+  {
+    EntryHeader const header = readHeader(src);
+    size_t const entry_size = ENTRY_HEADER_SIZE + header.length;
+    if (header.property != nullptr)
+    {
+      for (size_t i = 0; (i < entry_size) && (dst != src); i++)
+        _ring[wrap(dst + i)] = _ring[wrap(src + i)];
+      dst = wrap(dst + entry_size);
+      used += entry_size;
+    }
+    src = wrap(src + entry_size);
+    remaining -= entry_size;
+  }
+
+  _used = used;
+  _removed_bytes = 0;
+}
+
+PropertyOutbox::EntryHeader PropertyOutbox::readHeader(size_t const pos) const
+{
+  uint8_t raw[ENTRY_HEADER_SIZE];
+  EntryHeader header;
+  readRing(pos, raw, sizeof(raw));
+  memcpy(&header.length, raw, sizeof(header.length));
+  memcpy(&header.property, raw + sizeof(header.length), sizeof(header.property));
+  return header;
+}
+
+void PropertyOutbox::writeHeader(size_t const pos, EntryHeader const & header)
+{
+  uint8_t raw[ENTRY_HEADER_SIZE];
+  memcpy(raw, &header.length, sizeof(header.length));
+  memcpy(raw + sizeof(header.length), &header.property, sizeof(header.property));
+  writeRing(pos, raw, sizeof(raw));
+}
+
+void PropertyOutbox::readRing(size_t const pos, uint8_t * data, size_t const length) const
+{
+  size_t const first = std::min(length, _capacity - pos);
+  memcpy(data, _ring.data() + pos, first);
+  memcpy(data + first, _ring.data(), length - first);
+}
+
+void PropertyOutbox::writeRing(size_t const pos, uint8_t const * data, size_t const length)
+{
+  size_t const first = std::min(length, _capacity - pos);
+  memcpy(_ring.data() + pos, data, first);
+  memcpy(_ring.data(), data + first, length - first);
+}
@@ -0,0 +1,90 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#ifndef ARDUINO_PROPERTY_OUTBOX_H_
+#define ARDUINO_PROPERTY_OUTBOX_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#undef max
+#undef min
+#include <vector>
+
+#include "PropertyContainer.h"
+#include "../interfaces/Outbox.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Keeps the property snapshots into a single ring buffer of capacity bytes, allocated once by the first
+ * record. Each entry is the snapshot records prefixed by their length and property, the entries replaced
+ * by a newer snapshot of their property are left in place, marked as removed, until the space is needed.
+ */
+class PropertyOutbox : public Outbox
+{
+public:
+
+  /* Bytes taken by each entry in addition to its records */
+  static size_t const ENTRY_HEADER_SIZE = sizeof(uint16_t) + sizeof(Property *);
+
+  /* capacity bounds the bytes of all the queued entries, message_size is the size of the messages they are later encoded into */
+  PropertyOutbox(size_t const capacity, size_t const message_size);
+
+  /* Snapshot the changed properties stamped with time and mark them as sent. Depending on its coalescing policy the snapshot
+   * of a property replaces the one already queued or is queued after it. The oldest snapshots are dropped when the capacity
+   * is exceeded. Properties whose snapshot doesn't fit into a message are left pending.
+   */
+  virtual void record(PropertyContainer & property_container, unsigned long const time, bool lightPayload = false, bool compactRecords = false) override;
+  virtual size_t encode(uint8_t * data, size_t const size, int & bytes_encoded) override;
+  virtual void release(size_t const count) override;
+  void clear();
+
+  virtual bool  isEmpty        () const override { return _count == 0; }
+  inline size_t count          () const { return _count; }
+  inline size_t bytes          () const { return _bytes; }
+  inline size_t getDroppedCount() const { return _dropped_count; }
+
+private:
+
+  struct EntryHeader
+  {
+    uint16_t length;
+    Property * property;
+  };
+
+  size_t const _capacity;
+  size_t const _message_size;
+  std::vector<uint8_t> _ring;
+  size_t _head;
+  size_t _used;
+  size_t _removed_bytes;
+  size_t _count;
+  size_t _bytes;
+  size_t _dropped_count;
+  std::vector<uint8_t> _scratch;
+
+  void push(Property * property, uint8_t const * records, size_t const length);
+  void remove(Property * property);
+  void popFront();
+  void compact();
+  EntryHeader readHeader(size_t const pos) const;
+  void writeHeader(size_t const pos, EntryHeader const & header);
+  void readRing(size_t const pos, uint8_t * data, size_t const length) const;
+  void writeRing(size_t const pos, uint8_t const * data, size_t const length);
+  inline size_t wrap(size_t const pos) const { return pos % _capacity; }
+
+};
+
+#endif /* ARDUINO_PROPERTY_OUTBOX_H_ */
@@ -30,16 +30,170 @@
 #include <assert.h>
 
 #include "BearSSLTrustAnchors.h"
+#include "profile/aiotc_profile.h"
 #include "utility/eccX08_asn1.h"
 
 #include "BearSSLClient.h"
 
-extern "C" void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num);
+// ECDHE key share precomputed for the next handshake, on the curve chosen by the server in the last one.
+// The engine computes the shared secret with mul() and then its public point with mulgen(), in a row and
+// with the private key it just drew: the wrapping EC implementation swaps that key with the precomputed one
+// in mul(), and returns the precomputed point in mulgen().
+static struct {
+  bool ready;
+  bool swapped;
+  int curve;
+  unsigned char x[32];
+  unsigned char q[65];
+  size_t qlen;
+  unsigned char engineX[32];
+  const br_ec_impl* base;
+  br_ec_impl ec;
+} keyShare = { false, false, BR_EC_secp256r1, {0}, {0}, 0, {0}, NULL, {} };
+
+static uint32_t keyShareMul(unsigned char *G, size_t Glen, const unsigned char *x, size_t xlen, int curve)
+{
+  if (!keyShare.ready || curve != keyShare.curve || xlen != sizeof(keyShare.engineX)) {
+    return keyShare.base->mul(G, Glen, x, xlen, curve);
+  }
+
+  memcpy(keyShare.engineX, x, xlen);
+  keyShare.ready = false;
+  keyShare.swapped = true;
+  return keyShare.base->mul(G, Glen, keyShare.x, sizeof(keyShare.x), curve);
+}
+
+static size_t keyShareMulgen(unsigned char *R, const unsigned char *x, size_t xlen, int curve)
+{
+  if (!keyShare.swapped || xlen != sizeof(keyShare.engineX) || memcmp(x, keyShare.engineX, xlen) != 0) {
+    return keyShare.base->mulgen(R, x, xlen, curve);
+  }
+
+  size_t qlen = keyShare.qlen;
+  memcpy(R, keyShare.q, qlen);
+  BearSSLClient::clearKeyShare();
+  return qlen;
+}
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+// The handshake profiler times the X.509 engine, the ECDHE point multiplications and the signature through
+// wrappers installed by beginSSL(). Those callbacks have no client context, they add to the profile of the
+// last handshake started.
+static struct {
+  BearSSLClient::HandshakeProfile* profile;
+  const br_x509_class* vtable;
+  const br_x509_class** x509;
+  const br_ec_impl* base;
+  br_ec_impl ec;
+} profiler = { NULL, NULL, NULL, NULL, {} };
+
+static void profileX509StartChain(const br_x509_class **ctx, const char *server_name)
+{
+  (void)ctx;
+  unsigned long start = micros();
+  (*profiler.x509)->start_chain(profiler.x509, server_name);
+  profiler.profile->certValidation += micros() - start;
+}
+
+static void profileX509StartCert(const br_x509_class **ctx, uint32_t length)
+{
+  (void)ctx;
+  unsigned long start = micros();
+  (*profiler.x509)->start_cert(profiler.x509, length);
+  profiler.profile->certValidation += micros() - start;
+}
+
+static void profileX509Append(const br_x509_class **ctx, const unsigned char *buf, size_t len)
+{
+  (void)ctx;
+  unsigned long start = micros();
+  (*profiler.x509)->append(profiler.x509, buf, len);
+  profiler.profile->certValidation += micros() - start;
+}
+
+static void profileX509EndCert(const br_x509_class **ctx)
+{
+  (void)ctx;
+  unsigned long start = micros();
+  (*profiler.x509)->end_cert(profiler.x509);
+  profiler.profile->certValidation += micros() - start;
+}
+
+static unsigned profileX509EndChain(const br_x509_class **ctx)
+{
+  (void)ctx;
+  unsigned long start = micros();
+  unsigned result = (*profiler.x509)->end_chain(profiler.x509);
+  profiler.profile->certValidation += micros() - start;
+  return result;
+}
+
+static const br_x509_pkey* profileX509GetPkey(const br_x509_class *const *ctx, unsigned *usages)
+{
+  (void)ctx;
+  return (*profiler.x509)->get_pkey(profiler.x509, usages);
+}
+
+static const br_x509_class profileX509 = {
+  sizeof(const br_x509_class*),
+  profileX509StartChain,
+  profileX509StartCert,
+  profileX509Append,
+  profileX509EndCert,
+  profileX509EndChain,
+  profileX509GetPkey
+};
+
+static uint32_t profileMul(unsigned char *G, size_t Glen, const unsigned char *x, size_t xlen, int curve)
+{
+  unsigned long start = micros();
+  uint32_t result = profiler.base->mul(G, Glen, x, xlen, curve);
+  profiler.profile->keyExchange += micros() - start;
+  return result;
+}
+
+static size_t profileMulgen(unsigned char *R, const unsigned char *x, size_t xlen, int curve)
+{
+  unsigned long start = micros();
+  size_t result = profiler.base->mulgen(R, x, xlen, curve);
+  profiler.profile->keyExchange += micros() - start;
+  return result;
+}
+
+static size_t profileSign(const br_ec_impl *impl, const br_hash_class *hf, const void *hash_value, const br_ec_private_key *sk, void *sig)
+{
+  unsigned long start = micros();
+  size_t result = eccX08_sign_asn1(impl, hf, hash_value, sk, sig);
+  profiler.profile->sign += micros() - start;
+  return result;
+}
+#endif
 
 BearSSLClient::BearSSLClient() :
   _noSNI(false),
   _get_time_func(nullptr),
-  _sslio_closing(false)
+  _session_save_func(nullptr),
+  _sessionResumption(true),
+  _sessionValid(false),
+  _sessionResumed(false),
+  _sessionOffered(false),
+  _keyPinning(false),
+  _pinnedKeyValid(false),
+  _pinnedKeyUsed(false),
+  _fullValidationInterval(BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL),
+  _pinnedHandshakes(0),
+  _handshake(HandshakeStatus::Idle),
+  _sslio_closing(false),
+  _ibuf(nullptr),
+  _ibufLen(0),
+  _obuf(nullptr),
+  _obufLen(0),
+  _bufferPool(nullptr),
+  _lastError(BR_ERR_OK),
+  _maxFragmentLength(0),
+  _halfDuplex(false),
+  _maxFragmentLengthFallback(false),
+  _corked(0)
 {
   _ecKey.curve = 0;
   _ecKey.x = NULL;
@@ -48,6 +202,11 @@ BearSSLClient::BearSSLClient() :
   _ecCert.data = NULL;
   _ecCert.data_len = 0;
   _ecCertDynamic = false;
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  memset(&_profile, 0, sizeof(_profile));
+  _profiling = false;
+#endif
 }
 
 BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs, int myNumTAs, GetTimeCallbackFunc func) :
@@ -56,6 +215,27 @@ BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs,
   _numTAs(myNumTAs),
   _noSNI(false),
   _get_time_func(func),
+  _session_save_func(nullptr),
+  _sessionResumption(true),
+  _sessionValid(false),
+  _sessionResumed(false),
+  _sessionOffered(false),
+  _keyPinning(false),
+  _pinnedKeyValid(false),
+  _pinnedKeyUsed(false),
+  _fullValidationInterval(BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL),
+  _pinnedHandshakes(0),
+  _handshake(HandshakeStatus::Idle),
+  _ibuf(nullptr),
+  _ibufLen(0),
+  _obuf(nullptr),
+  _obufLen(0),
+  _bufferPool(nullptr),
+  _lastError(BR_ERR_OK),
+  _maxFragmentLength(0),
+  _halfDuplex(false),
+  _maxFragmentLengthFallback(false),
+  _corked(0),
   _br_ssl_client_init_function(aiotc_client_profile_init)
 {
   assert(_get_time_func != nullptr);
@@ -67,6 +247,11 @@ BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs,
   _ecCert.data = NULL;
   _ecCert.data_len = 0;
   _ecCertDynamic = false;
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  memset(&_profile, 0, sizeof(_profile));
+  _profiling = false;
+#endif
 }
 
 BearSSLClient::~BearSSLClient()
@@ -79,18 +264,36 @@ BearSSLClient::~BearSSLClient()
 
 int BearSSLClient::connect(IPAddress ip, uint16_t port)
 {
+  // adopt the connection established by connectAsync()
+  if (_handshake == HandshakeStatus::Established) {
+    _handshake = HandshakeStatus::Idle;
+    return 1;
+  }
+
+  profileBegin();
   if (!_client->connect(ip, port)) {
+    profileEnd(false);
     return 0;
   }
+  profileConnected();
 
   return connectSSL(NULL);
 }
 
 int BearSSLClient::connect(const char* host, uint16_t port)
 {
+  // adopt the connection established by connectAsync()
+  if (_handshake == HandshakeStatus::Established) {
+    _handshake = HandshakeStatus::Idle;
+    return 1;
+  }
+
+  profileBegin();
   if (!_client->connect(host, port)) {
+    profileEnd(false);
     return 0;
   }
+  profileConnected();
 
   return connectSSL(_noSNI ? NULL : host);
 }
@@ -115,7 +318,8 @@ size_t BearSSLClient::write(const uint8_t *buf, size_t size)
     written += result;
   }
 
-  if (written == size && br_sslio_flush(&_ioc) < 0) {
+  // when corked the record is closed once full or by uncork()
+  if (written == size && _corked == 0 && br_sslio_flush(&_ioc) < 0) {
     return 0;
   }
 
@@ -169,6 +373,9 @@ void BearSSLClient::flush()
 
 void BearSSLClient::stop()
 {
+  _handshake = HandshakeStatus::Idle;
+  _corked = 0;
+
   if (_client->connected()) {
     if ((br_ssl_engine_current_state(&_sc.eng) & BR_SSL_CLOSED) == 0) {
       _sslio_closing = true;
@@ -177,10 +384,18 @@ void BearSSLClient::stop()
 
     _client->stop();
   }
+
+  checkMaxFragmentLength();
+  releaseBuffers();
 }
 
 uint8_t BearSSLClient::connected()
 {
+  // a connection started by connectAsync() is not usable until adopted by connect()
+  if (_handshake != HandshakeStatus::Idle) {
+    return 0;
+  }
+
   if (!_client->connected()) {
     return 0;
   }
@@ -211,7 +426,7 @@ void BearSSLClient::setEccSlot(int ecc508KeySlot, const byte cert[], int certLen
 {
   // HACK: put the key slot info. in the br_ec_private_key structure
   _ecKey.curve = 23;
-  _ecKey.x = (unsigned char*)ecc508KeySlot;
+  _ecKey.x = (unsigned char*)(intptr_t)ecc508KeySlot;
   _ecKey.xlen = 32;
 
   _ecCert.data = (unsigned char*)cert;
@@ -267,20 +482,277 @@ void BearSSLClient::setEccSlot(int ecc508KeySlot, const char cert[])
   }
 }
 
+void BearSSLClient::setSession(const br_ssl_session_parameters& session)
+{
+  _session = session;
+  _sessionValid = (session.session_id_len > 0) && (session.session_id_len <= sizeof(session.session_id));
+}
+
+bool BearSSLClient::getSession(br_ssl_session_parameters& session)
+{
+  if (!_sessionValid) {
+    return false;
+  }
+
+  session = _session;
+  return true;
+}
+
+void BearSSLClient::clearSession()
+{
+  _sessionValid = false;
+  memset(&_session, 0, sizeof(_session));
+}
+
+void BearSSLClient::setKeyPinning(bool enable, unsigned int fullValidationInterval)
+{
+  _keyPinning = enable;
+  _fullValidationInterval = fullValidationInterval;
+}
+
+void BearSSLClient::setPinnedKey(const br_ec_public_key& key)
+{
+  if (key.qlen > sizeof(_pinnedKeyData)) {
+    clearPinnedKey();
+    return;
+  }
+
+  memcpy(_pinnedKeyData, key.q, key.qlen);
+  _pinnedKey.curve = key.curve;
+  _pinnedKey.q = _pinnedKeyData;
+  _pinnedKey.qlen = key.qlen;
+  _pinnedKeyValid = true;
+  _pinnedHandshakes = 0;
+}
+
+bool BearSSLClient::getPinnedKey(br_ec_public_key& key)
+{
+  if (!_pinnedKeyValid) {
+    return false;
+  }
+
+  key = _pinnedKey;
+  return true;
+}
+
+void BearSSLClient::clearPinnedKey()
+{
+  _pinnedKeyValid = false;
+  memset(&_pinnedKey, 0, sizeof(_pinnedKey));
+}
+
+bool BearSSLClient::precomputeKeyShare()
+{
+  if (keyShare.ready) {
+    return true;
+  }
+
+  unsigned char seed[32];
+
+  if (!(ECCX08.begin() && ECCX08.locked() && ECCX08.random(seed, sizeof(seed)))) {
+    for (size_t i = 0; i < sizeof(seed); i++) {
+      seed[i] = random(0, 255);
+    }
+  }
+
+  br_hmac_drbg_context rng;
+  br_ec_private_key sk;
+  br_ec_public_key pk;
+  unsigned char skBuf[BR_EC_KBUF_PRIV_MAX_SIZE];
+  unsigned char pkBuf[BR_EC_KBUF_PUB_MAX_SIZE];
+
+  br_hmac_drbg_init(&rng, &br_sha256_vtable, seed, sizeof(seed));
+  bool ready = br_ec_keygen(&rng.vtable, br_ec_get_default(), &sk, skBuf, keyShare.curve) == sizeof(keyShare.x) &&
+               br_ec_compute_pub(br_ec_get_default(), &pk, pkBuf, &sk) <= sizeof(keyShare.q);
+
+  if (ready) {
+    memcpy(keyShare.x, sk.x, sizeof(keyShare.x));
+    memcpy(keyShare.q, pk.q, pk.qlen);
+    keyShare.qlen = pk.qlen;
+    keyShare.ready = true;
+  }
+
+  memset(seed, 0, sizeof(seed));
+  memset(&rng, 0, sizeof(rng));
+  memset(skBuf, 0, sizeof(skBuf));
+  return ready;
+}
+
+bool BearSSLClient::hasKeyShare()
+{
+  return keyShare.ready;
+}
+
+void BearSSLClient::clearKeyShare()
+{
+  memset(keyShare.x, 0, sizeof(keyShare.x));
+  memset(keyShare.engineX, 0, sizeof(keyShare.engineX));
+  keyShare.ready = false;
+  keyShare.swapped = false;
+}
+
+void BearSSLClient::setMaxFragmentLength(uint16_t len, bool halfDuplex)
+{
+  _maxFragmentLength = len;
+  _halfDuplex = halfDuplex;
+  _maxFragmentLengthFallback = false;
+}
+
+int BearSSLClient::uncork()
+{
+  if (_corked == 0 || --_corked > 0) {
+    return 1;
+  }
+
+  return br_sslio_flush(&_ioc) < 0 ? 0 : 1;
+}
+
+int BearSSLClient::connectAsync(const char* host, uint16_t port)
+{
+  _handshake = HandshakeStatus::Idle;
+
+  profileBegin();
+  if (!_client->connect(host, port)) {
+    profileEnd(false);
+    return 0;
+  }
+  profileConnected();
+
+  if (!beginSSL(_noSNI ? NULL : host)) {
+    _client->stop();
+    return 0;
+  }
+
+  _handshake = HandshakeStatus::InProgress;
+  return 1;
+}
+
+BearSSLClient::HandshakeStatus BearSSLClient::poll()
+{
+  if (_handshake != HandshakeStatus::InProgress) {
+    return _handshake;
+  }
+
+  unsigned state = br_ssl_engine_current_state(&_sc.eng);
+  size_t len;
+
+  if (state & BR_SSL_CLOSED) {
+    handshakeFailed();
+  } else if (state & BR_SSL_SENDREC) {
+    // flush the records before checking for completion, the last one ends the handshake
+    unsigned char* buf = br_ssl_engine_sendrec_buf(&_sc.eng, &len);
+    int result = clientWrite(this, buf, len);
+
+    if (result < 0) {
+      handshakeFailed();
+    } else {
+      br_ssl_engine_sendrec_ack(&_sc.eng, result);
+    }
+  } else if (state & BR_SSL_SENDAPP) {
+    handshakeEstablished();
+  } else if ((state & BR_SSL_RECVREC) && (_client->available() > 0)) {
+    unsigned char* buf = br_ssl_engine_recvrec_buf(&_sc.eng, &len);
+    int result = clientRead(this, buf, len);
+
+    if (result < 0) {
+      handshakeFailed();
+    } else if (result > 0) {
+      br_ssl_engine_recvrec_ack(&_sc.eng, result);
+    }
+  } else if (!_client->connected()) {
+    handshakeFailed();
+  }
+
+  // report a failure only once
+  if (_handshake == HandshakeStatus::Failed) {
+    _client->stop();
+    releaseBuffers();
+    _handshake = HandshakeStatus::Idle;
+    return HandshakeStatus::Failed;
+  }
+
+  return _handshake;
+}
+
 int BearSSLClient::errorCode()
 {
+  if (_ibuf == nullptr) {
+    return _lastError;
+  }
   return br_ssl_engine_last_error(&_sc.eng);
 }
 
 int BearSSLClient::connectSSL(const char* host)
+{
+  if (!beginSSL(host)) {
+    _client->stop();
+    return 0;
+  }
+
+  br_sslio_flush(&_ioc);
+
+  while (1) {
+    unsigned state = br_ssl_engine_current_state(&_sc.eng);
+
+    if (state & BR_SSL_SENDAPP) {
+      break;
+    } else if (state & BR_SSL_CLOSED) {
+      handshakeFailed();
+      releaseBuffers();
+      _handshake = HandshakeStatus::Idle;
+      return 0;
+    }
+  }
+
+  handshakeEstablished();
+  _handshake = HandshakeStatus::Idle;
+  return 1;
+}
+
+bool BearSSLClient::beginSSL(const char* host)
 {
   /* Ensure this flag is cleared so we don't terminate a just starting connection. */
   _sslio_closing = false;
 
+  if (!acquireBuffers()) {
+    _lastError = BR_ERR_BAD_PARAM;
+    return false;
+  }
+
   // initialize client context with enabled algorithms and trust anchors
   _br_ssl_client_init_function(&_sc, &_xc, _TAs, _numTAs);
 
-  br_ssl_engine_set_buffers_bidi(&_sc.eng, _ibuf, sizeof(_ibuf), _obuf, sizeof(_obuf));
+  // let the engine use the precomputed key share
+  if (keyShare.ready) {
+    keyShare.base = br_ssl_engine_get_ec(&_sc.eng);
+    keyShare.ec = *keyShare.base;
+    keyShare.ec.mul = keyShareMul;
+    keyShare.ec.mulgen = keyShareMulgen;
+    br_ssl_engine_set_ec(&_sc.eng, &keyShare.ec);
+  }
+
+  // only check the server owns the pinned key instead of validating its chain
+  _pinnedKeyUsed = _keyPinning && _pinnedKeyValid && (_pinnedHandshakes < _fullValidationInterval);
+
+  if (_pinnedKeyUsed) {
+    br_x509_knownkey_init_ec(&_knownKey, &_pinnedKey, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN);
+    br_ssl_engine_set_x509(&_sc.eng, &_knownKey.vtable);
+  }
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  // time the X.509 engine and the ECDHE multiplications of this handshake
+  profiler.profile = &_profile;
+  profiler.x509 = _sc.eng.x509ctx;
+  profiler.vtable = &profileX509;
+  br_ssl_engine_set_x509(&_sc.eng, &profiler.vtable);
+  profiler.base = br_ssl_engine_get_ec(&_sc.eng);
+  profiler.ec = *profiler.base;
+  profiler.ec.mul = profileMul;
+  profiler.ec.mulgen = profileMulgen;
+  br_ssl_engine_set_ec(&_sc.eng, &profiler.ec);
+#endif
+
+  setEngineBuffers();
 
   // inject entropy in engine
   unsigned char entropy[32];
@@ -292,7 +764,11 @@ int BearSSLClient::connectSSL(const char* host)
 
     // enable client auth using the ECCX08
     if (_ecCert.data_len && _ecKey.xlen) {
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+      br_ssl_client_set_single_ec(&_sc, &_ecCert, 1, &_ecKey, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN, BR_KEYTYPE_EC, br_ec_get_default(), profileSign);
+#else
       br_ssl_client_set_single_ec(&_sc, &_ecCert, 1, &_ecKey, BR_KEYTYPE_KEYX | BR_KEYTYPE_SIGN, BR_KEYTYPE_EC, br_ec_get_default(), eccX08_sign_asn1);
+#endif
     }
   } else {
     // no ECCX08 or random failed, fallback to pseudo random
@@ -302,8 +778,16 @@ int BearSSLClient::connectSSL(const char* host)
   }
   br_ssl_engine_inject_entropy(&_sc.eng, entropy, sizeof(entropy));
 
+  // resume the last session if any, the server can still choose a full handshake
+  _sessionOffered = _sessionResumption && _sessionValid;
+  _sessionResumed = false;
+
+  if (_sessionOffered) {
+    br_ssl_engine_set_session_parameters(&_sc.eng, &_session);
+  }
+
   // set the hostname used for SNI
-  br_ssl_client_reset(&_sc, host, 0);
+  br_ssl_client_reset(&_sc, host, _sessionOffered ? 1 : 0);
 
   // get the current time and set it for X.509 validation
   uint32_t now = _get_time_func();
@@ -314,22 +798,183 @@ int BearSSLClient::connectSSL(const char* host)
 
   // use our own socket I/O operations
   br_sslio_init(&_ioc, &_sc.eng, BearSSLClient::clientRead, this, BearSSLClient::clientWrite, this);
+  return true;
+}
 
-  br_sslio_flush(&_ioc);
+bool BearSSLClient::acquireBuffers()
+{
+  if (_bufferPool == nullptr || _ibuf != nullptr) {
+    return _ibuf != nullptr;
+  }
 
-  while (1) {
-    unsigned state = br_ssl_engine_current_state(&_sc.eng);
+  if (!_bufferPool->acquire(_ibuf, _obuf)) {
+    return false;
+  }
 
-    if (state & BR_SSL_SENDAPP) {
-      break;
-    } else if (state & BR_SSL_CLOSED) {
-      return 0;
+  _ibufLen = _bufferPool->getIbufSize();
+  _obufLen = _bufferPool->getObufSize();
+  return true;
+}
+
+void BearSSLClient::releaseBuffers()
+{
+  if (_bufferPool == nullptr || _ibuf == nullptr) {
+    return;
+  }
+
+  // leave the engine closed, it must not touch the buffers once given back
+  _lastError = br_ssl_engine_last_error(&_sc.eng);
+  memset(&_sc, 0, sizeof(_sc));
+  _bufferPool->release(_ibuf);
+  _ibuf = nullptr;
+  _obuf = nullptr;
+}
+
+void BearSSLClient::setEngineBuffers()
+{
+  // the engine sizes the max_fragment_length extension after the buffers, see br_ssl_engine_set_buffers_bidi()
+  if (_maxFragmentLength && !_maxFragmentLengthFallback) {
+    size_t ibufLen = _maxFragmentLength + BR_SSL_BUFSIZE_INPUT - 16384;
+    size_t obufLen = _maxFragmentLength + BR_SSL_BUFSIZE_OUTPUT - 16384;
+
+    if (_halfDuplex || _obuf == nullptr) {
+      br_ssl_engine_set_buffer(&_sc.eng, _ibuf, ibufLen < _ibufLen ? ibufLen : _ibufLen, 0);
+    } else {
+      br_ssl_engine_set_buffers_bidi(&_sc.eng, _ibuf, ibufLen < _ibufLen ? ibufLen : _ibufLen,
+                                     _obuf, obufLen < _obufLen ? obufLen : _obufLen);
     }
+  } else if (_obuf == nullptr) {
+    br_ssl_engine_set_buffer(&_sc.eng, _ibuf, _ibufLen, 0);
+  } else {
+    br_ssl_engine_set_buffers_bidi(&_sc.eng, _ibuf, _ibufLen, _obuf, _obufLen);
   }
+}
 
-  return 1;
+void BearSSLClient::checkMaxFragmentLength()
+{
+  // a record larger than the negotiated fragments means the server ignored the extension
+  if (_maxFragmentLength && !_maxFragmentLengthFallback && br_ssl_engine_last_error(&_sc.eng) == BR_ERR_TOO_LARGE) {
+    _maxFragmentLengthFallback = true;
+  }
+}
+
+void BearSSLClient::handshakeFailed()
+{
+  _handshake = HandshakeStatus::Failed;
+  profileEnd(false);
+  checkMaxFragmentLength();
+
+  // do not try to resume a session the server may have dropped again
+  if (_sessionOffered) {
+    clearSession();
+  }
+
+  // the server key may have changed, validate its chain on the next handshake
+  if (_pinnedKeyUsed) {
+    _pinnedHandshakes = _fullValidationInterval;
+  }
+}
+
+void BearSSLClient::handshakeEstablished()
+{
+  _handshake = HandshakeStatus::Established;
+  profileEnd(true);
+
+  if (_sessionResumption) {
+    br_ssl_session_parameters session;
+    br_ssl_engine_get_session_parameters(&_sc.eng, &session);
+
+    // the server accepted the resumption if it echoed the same session id
+    _sessionResumed = _sessionOffered && (session.session_id_len == _session.session_id_len) &&
+                      (memcmp(session.session_id, _session.session_id, session.session_id_len) == 0);
+
+    if (!_sessionResumed) {
+      setSession(session);
+      if (_sessionValid && _session_save_func) {
+        _session_save_func(&_session);
+      }
+    }
+  }
+
+  // the next key share is precomputed on the curve the server prefers
+  if (!_sessionResumed && _sc.eng.ecdhe_curve != 0) {
+    keyShare.curve = _sc.eng.ecdhe_curve;
+  }
+
+  // a resumed session does not authenticate the server key again
+  if (_keyPinning && !_sessionResumed) {
+    updatePinnedKey();
+  }
+}
+
+void BearSSLClient::updatePinnedKey()
+{
+  if (_pinnedKeyUsed) {
+    _pinnedHandshakes++;
+    return;
+  }
+
+  // pin the key of the chain just validated
+  const br_x509_pkey* pkey = (*_sc.eng.x509ctx)->get_pkey(_sc.eng.x509ctx, NULL);
+
+  if (pkey != NULL && pkey->key_type == BR_KEYTYPE_EC) {
+    setPinnedKey(pkey->key.ec);
+  } else {
+    clearPinnedKey();
+  }
+}
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+void BearSSLClient::profileBegin()
+{
+  memset(&_profile, 0, sizeof(_profile));
+  _profiling = true;
+  _profileFlights = 0;
+  _profileStart = micros();
+  _profileLast = _profileStart;
+}
+
+void BearSSLClient::profileConnected()
+{
+  _profileLast = micros();
+  _profile.tcpConnect = _profileLast - _profileStart;
 }
 
+void BearSSLClient::profileTransfer(bool received, size_t len)
+{
+  if (!_profiling) {
+    return;
+  }
+
+  // the engine sends all its records before reading, a flight ends when the direction changes
+  if (_profileFlights == 0 || received != _profileReceiving) {
+    _profileFlights++;
+    _profileReceiving = received;
+    _profileFlightStart = _profileLast;
+  }
+  _profileLast = micros();
+
+  unsigned long* durations[] = { &_profile.clientHello, &_profile.serverHello, &_profile.clientFinished, &_profile.serverFinished };
+  size_t* bytes[] = { &_profile.clientHelloBytes, &_profile.serverHelloBytes, &_profile.clientFinishedBytes, &_profile.serverFinishedBytes };
+
+  if (_profileFlights <= sizeof(durations) / sizeof(durations[0])) {
+    *durations[_profileFlights - 1] = _profileLast - _profileFlightStart;
+    *bytes[_profileFlights - 1] += len;
+  }
+}
+
+void BearSSLClient::profileEnd(bool established)
+{
+  if (!_profiling) {
+    return;
+  }
+
+  _profiling = false;
+  _profile.total = micros() - _profileStart;
+  _profile.established = established;
+}
+#endif
+
 // #define DEBUGSERIAL Serial
 
 int BearSSLClient::clientRead(void *ctx, unsigned char *buf, size_t len)
@@ -349,6 +994,7 @@ int BearSSLClient::clientRead(void *ctx, unsigned char *buf, size_t len)
   if (result == -1) {
     return 0;
   }
+  bc->profileTransfer(true, result);
 
 #ifdef DEBUGSERIAL
   DEBUGSERIAL.print("BearSSLClient::clientRead - ");
@@ -400,6 +1046,7 @@ int BearSSLClient::clientWrite(void *ctx, const unsigned char *buf, size_t len)
   if (result == 0) {
     return -1;
   }
+  bc->profileTransfer(false, result);
 
   return result;
 }
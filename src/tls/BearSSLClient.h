@@ -36,12 +36,23 @@
 #define BEAR_SSL_CLIENT_IBUF_SIZE 8192 + 85 + 325 - BEAR_SSL_CLIENT_OBUF_SIZE
 #endif
 
+#ifndef BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL
+#define BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL 16
+#endif
+
+// Define to 1 to record the duration and the bytes of each phase of the handshakes, see getHandshakeProfile()
+#ifndef BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+#define BEAR_SSL_CLIENT_HANDSHAKE_PROFILE 0
+#endif
+
 #include <Arduino.h>
 #include <Client.h>
 
 #include "bearssl/bearssl.h"
+#include "utility/TLSBufferPool.h"
 
 typedef unsigned long(*GetTimeCallbackFunc)();
+typedef void(*SessionSaveCallbackFunc)(const br_ssl_session_parameters* session);
 
 class BearSSLClient : public Client {
 
@@ -57,6 +68,90 @@ public:
   inline void setTrustAnchors(const br_x509_trust_anchor* myTAs, int myNumTAs) { _TAs = myTAs; _numTAs = myNumTAs; }
   inline void onGetTime(GetTimeCallbackFunc callback) { _get_time_func = callback;}
 
+  // The record buffers are either owned by the caller for the whole client lifetime, or borrowed from
+  // a pool when connecting and given back on stop(). One of them must be set before connecting, otherwise
+  // connect() fails and errorCode() returns BR_ERR_BAD_PARAM, as it does when the pool can't lend them.
+  inline void setBuffers(unsigned char* ibuf, size_t ibufLen, unsigned char* obuf, size_t obufLen) { _ibuf = ibuf; _ibufLen = ibufLen; _obuf = obuf; _obufLen = obufLen; _bufferPool = nullptr; }
+  inline void setBufferPool(TLSBufferPool& pool) { _ibuf = nullptr; _obuf = nullptr; _bufferPool = &pool; }
+
+  // Low memory mode: negotiate a max_fragment_length of len bytes (512, 1024, 2048 or 4096), the engine then
+  // only uses len plus the record overhead of each buffer. When half duplex a single buffer is shared by both
+  // directions, the pending data must be read before writing. If the server ignores the extension and sends a
+  // larger record, the connection fails and the next ones fall back to the whole buffers.
+  void setMaxFragmentLength(uint16_t len, bool halfDuplex = false);
+  inline bool isMaxFragmentLengthFallback() { return _maxFragmentLengthFallback; }
+
+  // Coalesce the data written until the matching uncork() into as few TLS records as possible, instead of
+  // closing a record at the end of each write(). Calls can be nested, the last uncork() sends the data.
+  inline void cork() { _corked++; }
+  int uncork();
+
+  // Resume the last TLS session on reconnection, skipping the certificate exchange and the key signature.
+  // The save callback is called when a new session is established: its parameters include the master
+  // secret, store them protected and restore them with setSession() to resume the session after a reset.
+  inline void setSessionResumption(bool enable) { _sessionResumption = enable; }
+  inline void onSessionSave(SessionSaveCallbackFunc callback) { _session_save_func = callback; }
+  inline bool isSessionResumed() { return _sessionResumed; }
+  void setSession(const br_ssl_session_parameters& session);
+  bool getSession(br_ssl_session_parameters& session);
+  void clearSession();
+
+  // Pinned server key: after a full chain validation the server public key is kept, and the next full
+  // handshakes only check the server owns that key (br_x509_knownkey), skipping the chain decoding and its
+  // signature verifications. The chain is validated again every fullValidationInterval pinned handshakes
+  // and after a pinned handshake fails, updating the key. Only EC keys are pinned.
+  void setKeyPinning(bool enable, unsigned int fullValidationInterval = BEAR_SSL_CLIENT_FULL_VALIDATION_INTERVAL);
+  inline bool isKeyPinned() { return _pinnedKeyUsed; }
+  void setPinnedKey(const br_ec_public_key& key);
+  bool getPinnedKey(br_ec_public_key& key);
+  void clearPinnedKey();
+
+  // Precompute the ECDHE key pair of the next full handshake, taking its point multiplication out of the
+  // reconnection path. The multiplication can not be split, call it when idle. The key share is shared by
+  // all the clients, used by a single handshake and on the curve chosen by the server in the last full
+  // handshake (secp256r1 before the first one). Returns true if a key share is ready.
+  static bool precomputeKeyShare();
+  static bool hasKeyShare();
+  static void clearKeyShare();
+
+  enum class HandshakeStatus {
+    Idle,
+    InProgress,
+    Established,
+    Failed
+  };
+
+  // Open the socket and start the TLS handshake without waiting for it: poll() advances it as far as the
+  // data available on the socket allows. Once established the connection is adopted by the next connect().
+  int connectAsync(const char* host, uint16_t port);
+  HandshakeStatus poll();
+
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  // Durations in microseconds of the last handshake. The phases end with the last byte of each flight, so
+  // they include the wait for the peer: ClientHello, server flight up to ServerHelloDone, client flight up to
+  // Finished, server ChangeCipherSpec and Finished. A resumed handshake ends with the client Finished, the
+  // server Finished comes in its ServerHello flight. The certificate validation, key exchange and signature
+  // times are spent within those phases. Only one handshake at a time is profiled, the last one started.
+  struct HandshakeProfile {
+    unsigned long tcpConnect;
+    unsigned long clientHello;
+    unsigned long serverHello;
+    unsigned long clientFinished;
+    unsigned long serverFinished;
+    unsigned long total;
+    unsigned long certValidation;
+    unsigned long keyExchange;
+    unsigned long sign;
+    size_t clientHelloBytes;
+    size_t serverHelloBytes;
+    size_t clientFinishedBytes;
+    size_t serverFinishedBytes;
+    bool established;
+  };
+
+  inline const HandshakeProfile& getHandshakeProfile() { return _profile; }
+#endif
+
   virtual int connect(IPAddress ip, uint16_t port);
   virtual int connect(const char* host, uint16_t port);
   virtual size_t write(uint8_t);
@@ -85,6 +180,25 @@ public:
 
 private:
   int connectSSL(const char* host);
+  bool beginSSL(const char* host);
+  bool acquireBuffers();
+  void releaseBuffers();
+  void setEngineBuffers();
+  void checkMaxFragmentLength();
+  void handshakeEstablished();
+  void handshakeFailed();
+  void updatePinnedKey();
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  void profileBegin();
+  void profileConnected();
+  void profileTransfer(bool received, size_t len);
+  void profileEnd(bool established);
+#else
+  inline void profileBegin() { }
+  inline void profileConnected() { }
+  inline void profileTransfer(bool, size_t) { }
+  inline void profileEnd(bool) { }
+#endif
   static int clientRead(void *ctx, unsigned char *buf, size_t len);
   static int clientWrite(void *ctx, const unsigned char *buf, size_t len);
   static void clientAppendCert(void *ctx, const void *data, size_t len);
@@ -95,6 +209,24 @@ private:
   int _numTAs;
   bool _noSNI;
   GetTimeCallbackFunc _get_time_func;
+  SessionSaveCallbackFunc _session_save_func;
+
+  bool _sessionResumption;
+  bool _sessionValid;
+  bool _sessionResumed;
+  bool _sessionOffered;
+  br_ssl_session_parameters _session;
+
+  bool _keyPinning;
+  bool _pinnedKeyValid;
+  bool _pinnedKeyUsed;
+  unsigned int _fullValidationInterval;
+  unsigned int _pinnedHandshakes;
+  br_ec_public_key _pinnedKey;
+  unsigned char _pinnedKeyData[BR_EC_KBUF_PUB_MAX_SIZE];
+  br_x509_knownkey_context _knownKey;
+
+  HandshakeStatus _handshake;
 
   br_ec_private_key _ecKey;
   br_x509_certificate _ecCert;
@@ -108,10 +240,29 @@ private:
   bool _sslio_closing;
   br_ssl_client_context _sc;
   br_x509_minimal_context _xc;
-  unsigned char _ibuf[BEAR_SSL_CLIENT_IBUF_SIZE];
-  unsigned char _obuf[BEAR_SSL_CLIENT_OBUF_SIZE];
+  unsigned char* _ibuf;
+  size_t _ibufLen;
+  unsigned char* _obuf;
+  size_t _obufLen;
+  TLSBufferPool* _bufferPool;
+  // the engine is cleared when the pool buffers are given back, its last error is kept here
+  int _lastError;
+  uint16_t _maxFragmentLength;
+  bool _halfDuplex;
+  bool _maxFragmentLengthFallback;
+  unsigned int _corked;
   br_sslio_context _ioc;
 
+#if BEAR_SSL_CLIENT_HANDSHAKE_PROFILE
+  HandshakeProfile _profile;
+  bool _profiling;
+  bool _profileReceiving;
+  unsigned int _profileFlights;
+  unsigned long _profileStart;
+  unsigned long _profileFlightStart;
+  unsigned long _profileLast;
+#endif
+
   void (*_br_ssl_client_init_function)(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num);
 };
 
@@ -25,9 +25,103 @@
 #include <AIoTC_Config.h>
 #ifdef BOARD_HAS_ECCX08
 
+#include "aiotc_profile.h"
 #include "../bearssl/inner.h"
 
-/* see bearssl_ssl.h */
+/*
+ * Configuration selected with aiotc_client_profile_configure, all zero
+ * for the defaults of the platform.
+ */
+static aiotc_profile_config aiotc_config;
+
+static int
+aiotc_has_suite(const uint16_t *suites, size_t suites_num, uint16_t suite)
+{
+  size_t u;
+
+  for (u = 0; u < suites_num; u ++) {
+    if (suites[u] == suite) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* see aiotc_profile.h */
+void aiotc_client_profile_defaults(aiotc_profile_config *cfg)
+{
+  static const uint16_t suites[] = {
+    BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+  };
+
+  cfg->suites = suites;
+  cfg->suites_num = (sizeof suites) / (sizeof suites[0]);
+
+  /*
+   * AES-NI and PCLMULQDQ are checked at runtime, the host may not
+   * have them even when the compiler does.
+   */
+  cfg->aes_ctr = NULL;
+  cfg->ghash = 0;
+#if BR_AES_X86NI
+  cfg->aes_ctr = br_aes_x86ni_ctr_get_vtable();
+  cfg->ghash = br_ghash_pclmul_get();
+#endif
+  if (cfg->aes_ctr == NULL) {
+#if BR_64
+    cfg->aes_ctr = &br_aes_ct64_ctr_vtable;
+#else
+    cfg->aes_ctr = &br_aes_ct_ctr_vtable;
+#endif
+  }
+  if (cfg->ghash == 0) {
+#if BR_64
+    cfg->ghash = &br_ghash_ctmul64;
+#elif BR_ARMEL_CORTEXM_GCC || BR_LOMUL
+    cfg->ghash = &br_ghash_ctmul32;
+#else
+    cfg->ghash = &br_ghash_ctmul;
+#endif
+  }
+
+  /*
+   * Referencing the ChaCha20 and Poly1305 implementations links them
+   * into the image, even when the suite is never offered.
+   */
+  cfg->chacha20 = 0;
+  cfg->poly1305 = 0;
+#if AIOTC_PROFILE_CHAPOL
+#if BR_SSE2
+  cfg->chacha20 = br_chacha20_sse2_get();
+#endif
+  if (cfg->chacha20 == 0) {
+    cfg->chacha20 = &br_chacha20_ct_run;
+  }
+
+#if BR_INT128 || BR_UMUL128
+  cfg->poly1305 = br_poly1305_ctmulq_get();
+#endif
+  if (cfg->poly1305 == 0) {
+#if BR_LOMUL
+    cfg->poly1305 = &br_poly1305_ctmul32_run;
+#else
+    cfg->poly1305 = &br_poly1305_ctmul_run;
+#endif
+  }
+#endif
+}
+
+/* see aiotc_profile.h */
+void aiotc_client_profile_configure(const aiotc_profile_config *cfg)
+{
+  if (cfg == NULL) {
+    memset(&aiotc_config, 0, sizeof aiotc_config);
+  } else {
+    aiotc_config = *cfg;
+  }
+}
+
+/* see aiotc_profile.h */
 void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num)
 {
   /*
@@ -47,9 +141,52 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
    * -- AES-128 is preferred over AES-256 (AES-128 is already
    *    strong enough, and AES-256 is 40% more expensive).
    */
-  static const uint16_t suites[] = {
-    BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
-  };
+  aiotc_profile_config cfg;
+#if !AIOTC_PROFILE_CHAPOL
+  uint16_t suites[BR_MAX_CIPHER_SUITES];
+  size_t u, suites_num;
+#endif
+
+  /*
+   * Implementations which are not configured are the ones of the
+   * platform.
+   */
+  aiotc_client_profile_defaults(&cfg);
+#if AIOTC_PROFILE_CHAPOL
+  if (aiotc_config.suites_num != 0) {
+    cfg.suites = aiotc_config.suites;
+    cfg.suites_num = aiotc_config.suites_num;
+  }
+#else
+  /*
+   * Without its implementations ChaCha20-Poly1305 can't be offered,
+   * the default suite is kept if no other one is configured.
+   */
+  suites_num = 0;
+  for (u = 0; u < aiotc_config.suites_num && suites_num < BR_MAX_CIPHER_SUITES; u ++) {
+    if (aiotc_config.suites[u] != BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256) {
+      suites[suites_num ++] = aiotc_config.suites[u];
+    }
+  }
+  if (suites_num != 0) {
+    cfg.suites = suites;
+    cfg.suites_num = suites_num;
+  }
+#endif
+  if (aiotc_config.aes_ctr != NULL) {
+    cfg.aes_ctr = aiotc_config.aes_ctr;
+  }
+  if (aiotc_config.ghash != 0) {
+    cfg.ghash = aiotc_config.ghash;
+  }
+#if AIOTC_PROFILE_CHAPOL
+  if (aiotc_config.chacha20 != 0) {
+    cfg.chacha20 = aiotc_config.chacha20;
+  }
+  if (aiotc_config.poly1305 != 0) {
+    cfg.poly1305 = aiotc_config.poly1305;
+  }
+#endif
 
   /*
    * Reset client context and set supported versions from TLS-1.0
@@ -70,7 +207,7 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
    * implementation).
    * TODO: change that when better implementations are made available.
    */
-  br_ssl_engine_set_suites(&cc->eng, suites, (sizeof suites) / (sizeof suites[0]));
+  br_ssl_engine_set_suites(&cc->eng, cfg.suites, cfg.suites_num);
   br_ssl_engine_set_default_ecdsa(&cc->eng);
   br_x509_minimal_set_ecdsa(xc, br_ssl_engine_get_ec(&cc->eng), br_ssl_engine_get_ecdsa(&cc->eng));
 
@@ -92,10 +229,22 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
   br_ssl_engine_set_prf_sha256(&cc->eng, &br_tls12_sha256_prf);
 
   /*
-   * Symmetric encryption. We use the "default" implementations
-   * (fastest among constant-time implementations).
+   * Symmetric encryption, only for the offered suites. The
+   * implementations default to the fastest constant-time ones of
+   * the platform.
    */
-  br_ssl_engine_set_default_aes_gcm(&cc->eng);
+  if (aiotc_has_suite(cfg.suites, cfg.suites_num, BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256)) {
+    br_ssl_engine_set_gcm(&cc->eng, &br_sslrec_in_gcm_vtable, &br_sslrec_out_gcm_vtable);
+    br_ssl_engine_set_aes_ctr(&cc->eng, cfg.aes_ctr);
+    br_ssl_engine_set_ghash(&cc->eng, cfg.ghash);
+  }
+#if AIOTC_PROFILE_CHAPOL
+  if (aiotc_has_suite(cfg.suites, cfg.suites_num, BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256)) {
+    br_ssl_engine_set_chapol(&cc->eng, &br_sslrec_in_chapol_vtable, &br_sslrec_out_chapol_vtable);
+    br_ssl_engine_set_chacha20(&cc->eng, cfg.chacha20);
+    br_ssl_engine_set_poly1305(&cc->eng, cfg.poly1305);
+  }
+#endif
 }
 
 #endif /* #ifdef BOARD_HAS_ECCX08 */
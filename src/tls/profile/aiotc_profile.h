@@ -0,0 +1,95 @@
+/*
+ * This file is part of ArduinoIoTCloud.
+ *
+ * Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+ *
+ * This software is released under the GNU General Public License version 3,
+ * which covers the main part of arduino-cli.
+ * The terms of this license can be found at:
+ * https://www.gnu.org/licenses/gpl-3.0.en.html
+ *
+ * You can be released from the requirements of the above licenses by purchasing
+ * a commercial license. Buying such a license is mandatory if you want to modify or
+ * otherwise use the software for commercial activities involving the Arduino
+ * software without disclosing the source code of your own applications. To purchase
+ * a commercial license, send an email to license@arduino.cc.
+ */
+
+#ifndef AIOTC_PROFILE_H_
+#define AIOTC_PROFILE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+#ifdef BOARD_HAS_ECCX08
+
+#include "../bearssl/bearssl.h"
+
+/*
+ * Define to 1 to link the ChaCha20 and Poly1305 implementations and allow
+ * the ChaCha20-Poly1305 suite. They are left out by default to keep them
+ * out of the image, the suite is then removed from the configured ones.
+ */
+#ifndef AIOTC_PROFILE_CHAPOL
+#define AIOTC_PROFILE_CHAPOL 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/*
+ * Cipher suites and symmetric crypto implementations of the client profile.
+ *
+ * The suites are offered in the given order of preference, among
+ * BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256 and
+ * BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256. A zero suites_num offers
+ * AES-128/GCM only, and a NULL implementation selects the one of the platform
+ * returned by aiotc_client_profile_defaults. ChaCha20-Poly1305 is offered
+ * only when AIOTC_PROFILE_CHAPOL is 1.
+ */
+typedef struct {
+  const uint16_t *suites;
+  size_t suites_num;
+  const br_block_ctr_class *aes_ctr;
+  br_ghash ghash;
+  br_chacha20_run chacha20;
+  br_poly1305_run poly1305;
+} aiotc_profile_config;
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/*
+ * Fill cfg with the AES-128/GCM suite and the fastest constant-time
+ * implementations of the platform: aes_x86ni and ghash_pclmul on a host
+ * with AES-NI, aes_ct64 and ghash_ctmul64 on other 64-bit hosts, aes_ct and
+ * ghash_ctmul32 on Cortex-M and the other boards. chacha20 and poly1305
+ * are NULL unless AIOTC_PROFILE_CHAPOL is 1.
+ */
+void aiotc_client_profile_defaults(aiotc_profile_config *cfg);
+
+/*
+ * Select the configuration used by the next handshakes of all the clients
+ * using aiotc_client_profile_init, NULL restores the defaults. The
+ * configuration is copied, the suites array is not and must outlive it.
+ */
+void aiotc_client_profile_configure(const aiotc_profile_config *cfg);
+
+/* BearSSLClient profile, see br_ssl_client_init_full */
+void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifdef BOARD_HAS_ECCX08 */
+
+#endif /* AIOTC_PROFILE_H_ */
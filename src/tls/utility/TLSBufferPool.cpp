@@ -0,0 +1,62 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "TLSBufferPool.h"
+
+#include <stdlib.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+TLSBufferPool::TLSBufferPool(size_t const ibuf_size, size_t const obuf_size)
+: _ibuf_size{ibuf_size}
+, _obuf_size{obuf_size}
+, _buf{nullptr}
+{
+
+}
+
+TLSBufferPool::~TLSBufferPool()
+{
+  free(_buf);
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool TLSBufferPool::acquire(unsigned char * & ibuf, unsigned char * & obuf)
+{
+  if (_buf != nullptr)
+    return false;
+
+  /* A single allocation for both the buffers, to fragment the heap the least */
+  _buf = static_cast<unsigned char *>(malloc(_ibuf_size + _obuf_size));
+  if (_buf == nullptr)
+    return false;
+
+  ibuf = _buf;
+  obuf = _buf + _ibuf_size;
+  return true;
+}
+
+void TLSBufferPool::release(unsigned char * const ibuf)
+{
+  if (ibuf == nullptr || ibuf != _buf)
+    return;
+
+  free(_buf);
+  _buf = nullptr;
+}
@@ -0,0 +1,50 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#ifndef ARDUINO_TLS_BUFFER_POOL_H_
+#define ARDUINO_TLS_BUFFER_POOL_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Lends the record buffers of a TLS engine to the clients that only need them
+ * from time to time, i.e. the OTA download. The memory is allocated when the
+ * buffers are borrowed and freed as soon as they are given back.
+ */
+class TLSBufferPool
+{
+public:
+
+  TLSBufferPool(size_t const ibuf_size, size_t const obuf_size);
+  ~TLSBufferPool();
+
+  /* Returns false if the buffers are already lent or can not be allocated */
+  bool acquire(unsigned char * & ibuf, unsigned char * & obuf);
+  void release(unsigned char * const ibuf);
+
+  inline size_t getIbufSize() const { return _ibuf_size; }
+  inline size_t getObufSize() const { return _obuf_size; }
+  inline bool   isLent     () const { return _buf != nullptr; }
+
+private:
+
+  size_t const _ibuf_size;
+  size_t const _obuf_size;
+  unsigned char * _buf;
+};
+
+#endif /* ARDUINO_TLS_BUFFER_POOL_H_ */
@@ -24,11 +24,8 @@
 
 #ifdef BOARD_HAS_ECCX08
   #include "tls/BearSSLTrustAnchors.h"
+  #include "tls/profile/aiotc_profile.h"
   extern "C" {
-  void aiotc_client_profile_init(br_ssl_client_context *cc,
-                                 br_x509_minimal_context *xc,
-                                 const br_x509_trust_anchor *trust_anchors,
-                                 size_t trust_anchors_num);
   unsigned long getTime();
   }
 #endif
@@ -44,6 +41,7 @@ void TLSClientMqtt::begin(ConnectionHandler & connection) {
   setProfile(aiotc_client_profile_init);
   setTrustAnchors(ArduinoIoTCloudTrustAnchor, ArduinoIoTCloudTrustAnchor_NUM);
   onGetTime(getTime);
+  setBuffers(_ibuf_storage, sizeof(_ibuf_storage), _obuf_storage, sizeof(_obuf_storage));
 #elif defined(ARDUINO_PORTENTA_C33)
   setClient(connection.getClient());
   setCACert(AIoTSSCert);
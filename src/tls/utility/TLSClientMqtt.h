@@ -66,4 +66,11 @@
 public:
   void begin(ConnectionHandler & connection);
 
+#if defined(BOARD_HAS_ECCX08)
+private:
+  /* The broker connection is always open, keep its TLS buffers out of the heap */
+  unsigned char _ibuf_storage[BEAR_SSL_CLIENT_IBUF_SIZE];
+  unsigned char _obuf_storage[BEAR_SSL_CLIENT_OBUF_SIZE];
+#endif
+
 };
@@ -45,7 +45,7 @@ eccX08_sign_asn1(const br_ec_impl * /*impl*/,
     return 0;
   }
 
-  if (!ECCX08.ecSign((int)(sk->x), (const uint8_t*)hash_value, (uint8_t*)rsig)) {
+  if (!ECCX08.ecSign((int)(intptr_t)(sk->x), (const uint8_t*)hash_value, (uint8_t*)rsig)) {
     return 0;
   }
   sig_len = 64;
@@ -0,0 +1,160 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#ifdef HAS_TCP
+
+#include "MqttAckClient.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MqttAckClient::MqttAckClient()
+: _client{nullptr}
+, _on_puback{nullptr}
+, _last_publish_packet_id{0}
+, _session_present{false}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+int MqttAckClient::connect(IPAddress ip, uint16_t port)
+{
+  _tx.reset();
+  _rx.reset();
+  _session_present = false;
+  return _client->connect(ip, port);
+}
+
+int MqttAckClient::connect(const char * host, uint16_t port)
+{
+  _tx.reset();
+  _rx.reset();
+  _session_present = false;
+  return _client->connect(host, port);
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+int MqttAckClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+  _tx.reset();
+  _rx.reset();
+  _session_present = false;
+  return _client->connect(ip, port, timeout);
+}
+
+int MqttAckClient::connect(const char * host, uint16_t port, int32_t timeout)
+{
+  _tx.reset();
+  _rx.reset();
+  _session_present = false;
+  return _client->connect(host, port, timeout);
+}
+#endif
+
+size_t MqttAckClient::write(uint8_t b)
+{
+  size_t const written = _client->write(b);
+  onSent(&b, written);
+  return written;
+}
+
+size_t MqttAckClient::write(const uint8_t * buf, size_t size)
+{
+  size_t const written = _client->write(buf, size);
+  onSent(buf, written);
+  return written;
+}
+
+int MqttAckClient::available()
+{
+  return _client->available();
+}
+
+int MqttAckClient::read()
+{
+  int const b = _client->read();
+  if (b >= 0) {
+    uint8_t const byte = static_cast<uint8_t>(b);
+    onReceived(&byte, 1);
+  }
+  return b;
+}
+
+int MqttAckClient::read(uint8_t * buf, size_t size)
+{
+  int const received = _client->read(buf, size);
+  if (received > 0)
+    onReceived(buf, static_cast<size_t>(received));
+  return received;
+}
+
+int MqttAckClient::peek()
+{
+  return _client->peek();
+}
+
+void MqttAckClient::flush()
+{
+  _client->flush();
+}
+
+void MqttAckClient::stop()
+{
+  _client->stop();
+}
+
+uint8_t MqttAckClient::connected()
+{
+  return _client->connected();
+}
+
+MqttAckClient::operator bool()
+{
+  return static_cast<bool>(*_client);
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void MqttAckClient::onSent(uint8_t const * buf, size_t const size)
+{
+  _tx.feed(buf, size, [this](MqttPacketType const type, uint16_t const packet_id)
+  {
+    if (type == MqttPacketType::Publish)
+      _last_publish_packet_id = packet_id;
+  });
+}
+
+void MqttAckClient::onReceived(uint8_t const * buf, size_t const size)
+{
+  _rx.feed(buf, size, [this](MqttPacketType const type, uint16_t const packet_id)
+  {
+    if ((type == MqttPacketType::PubAck) && _on_puback)
+      _on_puback(packet_id);
+
+    /* Acknowledge flags and return code: the session is present if accepted with bit 0 set */
+    if (type == MqttPacketType::ConnAck)
+      _session_present = ((packet_id & 0x00FF) == 0) && ((packet_id & 0x0100) != 0);
+  });
+}
+
+#endif /* HAS_TCP */
@@ -0,0 +1,76 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include "MqttPacketScanner.h"
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+typedef std::function<void(uint16_t const packet_id)> OnMqttPubAck;
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Client placed between the MQTT client and the transport. The MQTT client does not
+ * expose the packet identifiers, so they are read from the packets flowing through:
+ * the identifier of the last QoS 1 PUBLISH sent and the PUBACKs received. The session
+ * present flag of the CONNACK is read the same way.
+ */
+class MqttAckClient : public Client
+{
+public:
+
+  MqttAckClient();
+
+  inline void     setClient              (Client & client)    { _client = &client; }
+  inline void     onPubAck               (OnMqttPubAck cb)    { _on_puback = cb; }
+  inline uint16_t getLastPublishPacketId () const             { return _last_publish_packet_id; }
+  inline bool     isSessionPresent       () const             { return _session_present; }
+
+  virtual int connect(IPAddress ip, uint16_t port) override;
+  virtual int connect(const char * host, uint16_t port) override;
+#if defined(ARDUINO_ARCH_ESP32)
+  virtual int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+  virtual int connect(const char * host, uint16_t port, int32_t timeout) override;
+#endif
+  virtual size_t write(uint8_t b) override;
+  virtual size_t write(const uint8_t * buf, size_t size) override;
+  virtual int available() override;
+  virtual int read() override;
+  virtual int read(uint8_t * buf, size_t size) override;
+  virtual int peek() override;
+  virtual void flush() override;
+  virtual void stop() override;
+  virtual uint8_t connected() override;
+  virtual operator bool() override;
+
+private:
+
+  Client * _client;
+  MqttPacketScanner _tx;
+  MqttPacketScanner _rx;
+  OnMqttPubAck _on_puback;
+  uint16_t _last_publish_packet_id;
+  bool _session_present;
+
+  void onSent(uint8_t const * buf, size_t const size);
+  void onReceived(uint8_t const * buf, size_t const size);
+};
@@ -0,0 +1,120 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MqttInflightWindow.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MqttInflightWindow::MqttInflightWindow(size_t const slots, size_t const message_size)
+: _slots(slots)
+, _message_size{message_size}
+, _count{0}
+, _expired{0}
+, _order{0}
+{
+  for (Slot & slot : _slots)
+  {
+    slot.used = false;
+    slot.expired = false;
+    slot.packet_id = 0;
+    slot.order = 0;
+    slot.length = 0;
+  }
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MqttInflightWindow::add(uint16_t const packet_id, uint8_t const * data, size_t const length)
+{
+  for (Slot & slot : _slots)
+  {
+    if (slot.used)
+      continue;
+    if (length > _message_size)
+      return false;
+
+    /* The buffer of a slot is allocated by its first message, a window never used costs no heap */
+    if (slot.data.empty())
+      slot.data.resize(_message_size);
+
+    memcpy(slot.data.data(), data, length);
+    slot.used = true;
+    slot.expired = false;
+    slot.packet_id = packet_id;
+    slot.order = _order++;
+    slot.length = length;
+    _count++;
+    return true;
+  }
+  return false;
+}
+
+bool MqttInflightWindow::acknowledge(uint16_t const packet_id)
+{
+  for (Slot & slot : _slots)
+  {
+    if (slot.used && !slot.expired && (slot.packet_id == packet_id))
+    {
+      slot.used = false;
+      _count--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void MqttInflightWindow::expire()
+{
+  _expired = 0;
+  for (Slot & slot : _slots)
+  {
+    slot.expired = slot.used;
+    if (slot.expired)
+      _expired++;
+  }
+}
+
+size_t MqttInflightWindow::resend(ResendFunc const & resend_func)
+{
+  while (_expired > 0)
+  {
+    Slot * oldest = nullptr;
+    for (Slot & slot : _slots)
+    {
+      if (slot.used && slot.expired && ((oldest == nullptr) || (static_cast<int32_t>(slot.order - oldest->order) < 0)))
+        oldest = &slot;
+    }
+
+    if (!resend_func(oldest->packet_id, oldest->data.data(), oldest->length))
+      break;
+
+    oldest->expired = false;
+    _expired--;
+  }
+  return _expired;
+}
+
+void MqttInflightWindow::clear()
+{
+  for (Slot & slot : _slots)
+    slot.used = false;
+  _count = 0;
+  _expired = 0;
+}
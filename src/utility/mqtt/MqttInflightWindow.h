@@ -0,0 +1,77 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#ifndef ARDUINO_MQTT_INFLIGHT_WINDOW_H_
+#define ARDUINO_MQTT_INFLIGHT_WINDOW_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#undef max
+#undef min
+#include <functional>
+#include <vector>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Keeps a copy of the QoS 1 messages published and not yet acknowledged by the broker.
+ * Each slot is released by the PUBACK carrying its packet identifier. When the connection
+ * is lost the slots are expired and resent, oldest first, with the DUP flag set once connected
+ * again. Only the property messages are kept: streamed and command messages are still published
+ * with QoS 0 and are not resent.
+ */
+class MqttInflightWindow
+{
+public:
+
+  /* Returns true if the message has been published, updating the packet identifier */
+  typedef std::function<bool(uint16_t & packet_id, uint8_t const * data, size_t const length)> ResendFunc;
+
+  MqttInflightWindow(size_t const slots, size_t const message_size);
+
+  bool add(uint16_t const packet_id, uint8_t const * data, size_t const length);
+  bool acknowledge(uint16_t const packet_id);
+  /* The packet identifiers are no longer valid, every message will need to be resent */
+  void expire();
+  /* Resend the expired messages, oldest first, returns the number of messages still to be resent */
+  size_t resend(ResendFunc const & resend_func);
+  void clear();
+
+  inline bool   isEmpty   () const { return _count == 0; }
+  inline bool   isFull    () const { return _count == _slots.size(); }
+  inline bool   hasExpired() const { return _expired > 0; }
+  inline size_t count     () const { return _count; }
+
+private:
+
+  struct Slot
+  {
+    bool used;
+    bool expired;
+    uint16_t packet_id;
+    uint32_t order;
+    size_t length;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<Slot> _slots;
+  size_t const _message_size;
+  size_t _count;
+  size_t _expired;
+  uint32_t _order;
+};
+
+#endif /* ARDUINO_MQTT_INFLIGHT_WINDOW_H_ */
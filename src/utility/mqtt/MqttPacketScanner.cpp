@@ -0,0 +1,134 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MqttPacketScanner.h"
+
+#include <algorithm>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MqttPacketScanner::MqttPacketScanner()
+{
+  reset();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void MqttPacketScanner::reset()
+{
+  _state = State::Header;
+  _header = 0;
+  _length = 0;
+  _length_shift = 0;
+  _offset = 0;
+  _packet_id_offset = 0;
+  _packet_id = 0;
+}
+
+void MqttPacketScanner::feed(uint8_t const * data, size_t const length, OnMqttPacketId const & on_packet_id)
+{
+  size_t i = 0;
+
+  while (i < length)
+  {
+    switch (_state)
+    {
+      case State::Header:
+        _header = data[i++];
+        _length = 0;
+        _length_shift = 0;
+        _state = State::Length;
+        break;
+
+      case State::Length:
+      {
+        uint8_t const b = data[i++];
+        _length |= static_cast<uint32_t>(b & 0x7F) << _length_shift;
+        _length_shift += 7;
+
+        if (b & 0x80)
+        {
+          /* The remaining length is at most 4 bytes long, resynchronize on the next byte */
+          if (_length_shift > 21)
+            _state = State::Header;
+          break;
+        }
+
+        /* A PUBLISH packet identifier follows the topic, the others start the variable header */
+        _offset = 0;
+        _packet_id_offset = 0;
+        _packet_id = 0;
+        _state = (_length > 0) ? State::Body : State::Header;
+      }
+      break;
+
+      case State::Body:
+      {
+        if (hasPacketId() && (_offset < (_packet_id_offset + 2)))
+        {
+          uint8_t const b = data[i++];
+          bool const is_publish = static_cast<MqttPacketType>(_header >> 4) == MqttPacketType::Publish;
+
+          if (is_publish && (_offset == 0))
+            _packet_id_offset = static_cast<uint32_t>(b) << 8;
+          else if (is_publish && (_offset == 1))
+            _packet_id_offset = (_packet_id_offset | b) + 2;
+          else if (_offset == _packet_id_offset)
+            _packet_id = static_cast<uint16_t>(b) << 8;
+          else if (_offset == (_packet_id_offset + 1))
+          {
+            _packet_id |= b;
+            on_packet_id(static_cast<MqttPacketType>(_header >> 4), _packet_id);
+          }
+          _offset++;
+        }
+        else
+        {
+          /* Skip the rest of the packet */
+          size_t const skip = std::min(static_cast<size_t>(_length - _offset), length - i);
+          i += skip;
+          _offset += skip;
+        }
+
+        if (_offset >= _length)
+          _state = State::Header;
+      }
+      break;
+    }
+  }
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MqttPacketScanner::hasPacketId() const
+{
+  switch (static_cast<MqttPacketType>(_header >> 4))
+  {
+    case MqttPacketType::Publish:  return (_header & 0x06) != 0;
+    case MqttPacketType::ConnAck:
+    case MqttPacketType::PubAck:
+    case MqttPacketType::PubRec:
+    case MqttPacketType::PubRel:
+    case MqttPacketType::PubComp:
+    case MqttPacketType::SubAck:
+    case MqttPacketType::UnsubAck: return true;
+    default:                       return false;
+  }
+}
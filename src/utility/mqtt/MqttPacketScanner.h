@@ -0,0 +1,80 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#ifndef ARDUINO_MQTT_PACKET_SCANNER_H_
+#define ARDUINO_MQTT_PACKET_SCANNER_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#undef max
+#undef min
+#include <functional>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+enum class MqttPacketType : uint8_t
+{
+  ConnAck  = 2,
+  Publish  = 3,
+  PubAck   = 4,
+  PubRec   = 5,
+  PubRel   = 6,
+  PubComp  = 7,
+  SubAck   = 9,
+  UnsubAck = 11
+};
+
+typedef std::function<void(MqttPacketType const type, uint16_t const packet_id)> OnMqttPacketId;
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Follows the MQTT packets flowing on one direction of a connection, which can be
+ * fed in chunks of any size, and reports the packet identifiers they carry. A CONNACK
+ * has none, its acknowledge flags and return code are reported in their place.
+ */
+class MqttPacketScanner
+{
+public:
+
+  MqttPacketScanner();
+
+  void reset();
+  void feed(uint8_t const * data, size_t const length, OnMqttPacketId const & on_packet_id);
+
+private:
+
+  enum class State
+  {
+    Header,
+    Length,
+    Body
+  };
+
+  State _state;
+  uint8_t _header;
+  uint32_t _length;
+  uint8_t _length_shift;
+  uint32_t _offset;
+  uint32_t _packet_id_offset;
+  uint16_t _packet_id;
+
+  bool hasPacketId() const;
+};
+
+#endif /* ARDUINO_MQTT_PACKET_SCANNER_H_ */
@@ -188,6 +188,11 @@ bool TimeServiceClass::sync()
   return _is_rtc_configured;
 }
 
+bool TimeServiceClass::isSynced(unsigned long const max_age_ms)
+{
+  return _is_rtc_configured && ((millis() - _last_sync_tick) < max_age_ms);
+}
+
 void TimeServiceClass::setSyncInterval(unsigned long seconds)
 {
   _sync_interval_ms = seconds * 1000;
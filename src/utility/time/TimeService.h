@@ -48,6 +48,7 @@ public:
   unsigned long getLocalTime();
   void          setTimeZoneData(long offset, unsigned long valid_until);
   bool          sync();
+  bool          isSynced(unsigned long const max_age_ms);
   void          setSyncInterval(unsigned long seconds);
   void          setSyncFunction(syncTimeFunctionPtr sync_func);
 
@@ -21,7 +21,41 @@
 
 TimedAttempt::TimedAttempt(unsigned long minDelay, unsigned long maxDelay)
 : _minDelay(minDelay)
-, _maxDelay(maxDelay) {
+, _maxDelay(maxDelay)
+, _retryTick(0)
+, _retryDelay(0)
+, _retryCount(0)
+, _policy(exponentialBackoff)
+, _random(1) {
+}
+
+/******************************************************************************
+ * PUBLIC STATIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+unsigned long TimedAttempt::exponentialBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long /* lastDelay */, uint32_t /* random */) {
+  unsigned long shift = retryCount > 31 ? 31 : retryCount;
+  unsigned long delay = (1UL << shift) * minDelay;
+  return min(delay, maxDelay);
+}
+
+unsigned long TimedAttempt::fullJitterBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long lastDelay, uint32_t random) {
+  unsigned long const lower = minDelay / 2;
+  unsigned long const upper = exponentialBackoff(minDelay, maxDelay, retryCount, lastDelay, random);
+  if (upper <= lower) {
+    return upper;
+  }
+  return lower + random % (upper - lower + 1);
+}
+
+unsigned long TimedAttempt::decorrelatedJitterBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int /* retryCount */, unsigned long lastDelay, uint32_t random) {
+  unsigned long const lower = minDelay / 2;
+  unsigned long const last = lastDelay < minDelay ? minDelay : lastDelay;
+  unsigned long const upper = last > maxDelay / 3 ? maxDelay : last * 3;
+  if (upper <= lower) {
+    return upper;
+  }
+  return lower + random % (upper - lower + 1);
 }
 
 /******************************************************************************
@@ -55,10 +89,14 @@ unsigned long TimedAttempt::retry() {
   return reload();
 }
 
+void TimedAttempt::setBackoffPolicy(BackoffPolicy policy, uint32_t seed) {
+  _policy = policy ? policy : exponentialBackoff;
+  /* xorshift state must not be zero */
+  _random = seed ? seed : 1;
+}
+
 unsigned long TimedAttempt::reload() {
-  unsigned long shift = _retryCount > 31 ? 31 : _retryCount;
-  unsigned long delay = (1UL << shift) * _minDelay;
-  _retryDelay = min(delay, _maxDelay);
+  _retryDelay = _policy(_minDelay, _maxDelay, _retryCount, _retryDelay, nextRandom());
   _retryTick = millis();
   return _retryDelay;
 }
@@ -82,3 +120,14 @@ unsigned int TimedAttempt::getRetryCount() {
 unsigned int TimedAttempt::getWaitTime() {
   return _retryDelay;
 }
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+uint32_t TimedAttempt::nextRandom() {
+  _random ^= _random << 13;
+  _random ^= _random >> 17;
+  _random ^= _random << 5;
+  return _random;
+}
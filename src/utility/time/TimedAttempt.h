@@ -11,6 +11,12 @@
 #ifndef TIMED_ATTEMPT_H
 #define TIMED_ATTEMPT_H
 
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
 /******************************************************************************
  * CLASS DECLARATION
  ******************************************************************************/
@@ -18,8 +24,23 @@
 class TimedAttempt {
 
 public:
+  /* Returns the delay before the next attempt. random is a fresh 32 bit pseudo random
+   * value, lastDelay the delay returned for the previous attempt.
+   */
+  typedef unsigned long (*BackoffPolicy)(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long lastDelay, uint32_t random);
+
+  /* minDelay * 2^retryCount up to maxDelay, the default */
+  static unsigned long exponentialBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long lastDelay, uint32_t random);
+  /* Uniformly spread between minDelay / 2 and the exponential delay */
+  static unsigned long fullJitterBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long lastDelay, uint32_t random);
+  /* Uniformly spread between minDelay / 2 and three times the last delay, up to maxDelay */
+  static unsigned long decorrelatedJitterBackoff(unsigned long minDelay, unsigned long maxDelay, unsigned int retryCount, unsigned long lastDelay, uint32_t random);
+
   TimedAttempt(unsigned long minDelay, unsigned long maxDelay);
 
+  /* Devices sharing a policy should use different seeds, or they will retry in lockstep */
+  void setBackoffPolicy(BackoffPolicy policy, uint32_t seed);
+
   void begin(unsigned long delay);
   void begin(unsigned long minDelay, unsigned long maxDelay);
   unsigned long reconfigure(unsigned long minDelay, unsigned long maxDelay);
@@ -37,6 +58,10 @@ private:
   unsigned long _retryTick;
   unsigned long _retryDelay;
   unsigned int _retryCount;
+  BackoffPolicy _policy;
+  uint32_t _random;
+
+  uint32_t nextRandom();
 };
 
 #endif /* TIMED_ATTEMPT_H */